@@ -2,9 +2,11 @@
 #ifndef CRPROPA_H
 #define CRPROPA_H
 
+#include "crpropa/AliasTable.h"
 #include "crpropa/Candidate.h"
 #include "crpropa/Common.h"
 #include "crpropa/Cosmology.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/EmissionMap.h"
 #include "crpropa/Geometry.h"
 #include "crpropa/Grid.h"
@@ -17,9 +19,12 @@
 #include "crpropa/ParticleState.h"
 #include "crpropa/PhotonBackground.h"
 #include "crpropa/PhotonPropagation.h"
+#include "crpropa/PropertyKey.h"
 #include "crpropa/Random.h"
 #include "crpropa/Referenced.h"
 #include "crpropa/Source.h"
+#include "crpropa/TableRegistry.h"
+#include "crpropa/UniformLogTable.h"
 #include "crpropa/Units.h"
 #include "crpropa/Variant.h"
 #include "crpropa/Vector3.h"
@@ -29,6 +34,7 @@
 #include "crpropa/module/Acceleration.h"
 #include "crpropa/module/Boundary.h"
 #include "crpropa/module/BreakCondition.h"
+#include "crpropa/module/CompetingInteractions.h"
 #include "crpropa/module/DiffusionSDE.h"
 #include "crpropa/module/EMCascade.h"
 #include "crpropa/module/EMDoublePairProduction.h"
@@ -48,12 +54,15 @@
 #include "crpropa/module/PhotonOutput1D.h"
 #include "crpropa/module/PropagationBP.h"
 #include "crpropa/module/PropagationCK.h"
+#include "crpropa/module/PropagationDP.h"
+#include "crpropa/module/PropagationGuidingCenter.h"
 #include "crpropa/module/Redshift.h"
 #include "crpropa/module/RestrictToRegion.h"
 #include "crpropa/module/SimplePropagation.h"
 #include "crpropa/module/SynchrotronRadiation.h"
 #include "crpropa/module/TextOutput.h"
 #include "crpropa/module/Tools.h"
+#include "crpropa/module/WeightWindow.h"
 
 #include "crpropa/magneticField/AMRMagneticField.h"
 #include "crpropa/magneticField/ArchimedeanSpiralField.h"
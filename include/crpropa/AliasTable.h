@@ -0,0 +1,60 @@
+#ifndef CRPROPA_ALIASTABLE_H
+#define CRPROPA_ALIASTABLE_H
+
+#include "crpropa/Random.h"
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace crpropa {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ @class AliasTable
+ @brief Walker/Vose alias tables for drawing bins of discrete distributions
+
+ Holds a set of discrete distributions, each given by its (unnormalized)
+ cumulative distribution function as used by Random::randBin. A bin is
+ drawn in constant time from one random number and without allocation,
+ with the same probabilities as Random::randBin. The tables of all
+ distributions are stored contiguously.
+ */
+class AliasTable {
+public:
+	AliasTable();
+
+	/** Add a distribution given by its cumulative distribution function,
+	 without leading zero. Returns the index of the distribution. */
+	size_t add(const std::vector<double> &cdf);
+	size_t size() const; ///< number of distributions
+	size_t bins(size_t distribution) const; ///< number of bins of a distribution
+
+	/** Draw a bin of the given distribution */
+	size_t sample(size_t distribution, Random &random) const {
+		size_t first = offsets[distribution];
+		size_t n = offsets[distribution + 1] - first;
+		double u = random.rand53() * n;
+		size_t k = u;
+		if (k >= n) // guard against rounding
+			k = n - 1;
+		const Entry &e = entries[first + k];
+		return (u - k < e.probability) ? k : e.alias;
+	}
+
+private:
+	struct Entry {
+		double probability; // probability to keep bin k
+		uint32_t alias; // bin drawn otherwise
+	};
+	std::vector<Entry> entries;
+	std::vector<size_t> offsets;
+};
+
+/** @}*/
+} // namespace crpropa
+
+#endif // CRPROPA_ALIASTABLE_H
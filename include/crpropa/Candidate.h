@@ -2,8 +2,8 @@
 #define CRPROPA_CANDIDATE_H
 
 #include "crpropa/ParticleState.h"
+#include "crpropa/PropertyKey.h"
 #include "crpropa/Referenced.h"
-#include "crpropa/AssocVector.h"
 #include "crpropa/Variant.h"
 
 #include <vector>
@@ -33,8 +33,66 @@ public:
 
 	std::vector<ref_ptr<Candidate> > secondaries; /**< Secondary particles from interactions */
 
-	typedef Loki::AssocVector<std::string, Variant> PropertyMap;
-	PropertyMap properties; /**< Map of property names and their values. */
+	/**
+	 @class PropertyMap
+	 @brief Small map of property keys and their values.
+
+	 The first few properties are stored in slots inside the candidate,
+	 only candidates with more properties move them to the heap.
+	 */
+	class PropertyMap {
+	public:
+		typedef std::pair<PropertyKey, Variant> value_type;
+		typedef value_type *iterator;
+		typedef const value_type *const_iterator;
+
+		PropertyMap() : count(0), onHeap(false) {
+		}
+
+		iterator begin() {
+			return onHeap ? &heapSlots[0] : inlineSlots;
+		}
+		const_iterator begin() const {
+			return onHeap ? &heapSlots[0] : inlineSlots;
+		}
+		iterator end() {
+			return begin() + count;
+		}
+		const_iterator end() const {
+			return begin() + count;
+		}
+		size_t size() const {
+			return count;
+		}
+		bool empty() const {
+			return count == 0;
+		}
+
+		iterator find(const PropertyKey &key) {
+			iterator i = begin(), e = end();
+			while ((i != e) && (i->first != key))
+				++i;
+			return i;
+		}
+		const_iterator find(const PropertyKey &key) const {
+			const_iterator i = begin(), e = end();
+			while ((i != e) && (i->first != key))
+				++i;
+			return i;
+		}
+
+		Variant &operator[](const PropertyKey &key);
+		void erase(iterator i);
+		void clear();
+
+	private:
+		enum {nInlineSlots = 4};
+		value_type inlineSlots[nInlineSlots];
+		std::vector<value_type> heapSlots;
+		size_t count;
+		bool onHeap;
+	};
+	PropertyMap properties; /**< Map of property keys and their values. */
 
 	/** Parent candidate. 0 if no parent (initial particle). Must not be a ref_ptr to prevent circular referencing. */
 	Candidate *parent;
@@ -50,6 +108,14 @@ private:
 	static uint64_t nextSerialNumber;
 	uint64_t serialNumber;
 
+	uint64_t randomStream; /**< Id of the counter-based random stream of the candidate */
+	uint64_t randomCounter; /**< Number of random integers drawn from the stream so far */
+	uint64_t secondaryCounter; /**< Number of secondaries added so far, also counting the released ones */
+
+	static bool poolAllocation;
+	static size_t maximumPoolSize;
+	static size_t maximumBufferCapacity;
+
 public:
 	Candidate(
 		int id = 0,
@@ -66,6 +132,9 @@ public:
 	 */
 	Candidate(const ParticleState &state);
 
+	/** Returns the storage of the secondaries to the pool, if enabled */
+	~Candidate();
+
 	bool isActive() const;
 	void setActive(bool b);
 
@@ -106,6 +175,12 @@ public:
 	bool removeProperty(const std::string &name);
 	bool hasProperty(const std::string &name) const;
 
+	/** Access to properties by interned keys, avoids the lookup of the name */
+	void setProperty(const PropertyKey &key, const Variant &value);
+	const Variant &getProperty(const PropertyKey &key) const;
+	bool removeProperty(const PropertyKey &key);
+	bool hasProperty(const PropertyKey &key) const;
+
 	/**
 	 Add a new candidate to the list of secondaries.
 	 @param id		particle ID of the secondary
@@ -134,6 +209,17 @@ public:
 	/** Serial number of candidate at creation */
 	uint64_t getCreatedSerialNumber() const;
 
+	/**
+	 Counter-based random stream of the candidate, see Random::setStream.
+	 The n-th secondary ever added to the candidate gets the stream
+	 Random::deriveStream(stream, n), also if earlier secondaries have
+	 been removed with clearSecondaries.
+	 */
+	void setRandomStream(uint64_t stream, uint64_t counter = 0);
+	uint64_t getRandomStream() const;
+	uint64_t getRandomCounter() const;
+	void setRandomCounter(uint64_t counter);
+
 	/** Set the next serial number to use */
 	static void setNextSerialNumber(uint64_t snr);
 
@@ -151,6 +237,35 @@ public:
 	 and activate it if inactive, e.g. restart it
 	*/
 	void restart();
+
+	/**
+	 Enable or disable the per-thread pool for candidates (enabled by default).
+	 Deleted candidates and the storage of their secondaries are kept in a
+	 pool of the deleting thread and reused for new candidates, which
+	 avoids most calls to malloc and free in large cascades. If disabled,
+	 plain allocation is used.
+	 */
+	static void setPoolAllocation(bool enable);
+	static bool getPoolAllocation();
+
+	/**
+	 Maximum number of recycled candidates and of recycled secondary buffers
+	 kept in the pool of each thread
+	 */
+	static void setMaximumPoolSize(size_t size);
+	static size_t getMaximumPoolSize();
+
+	/**
+	 Maximum capacity (number of entries) of a secondary buffer that is
+	 returned to the pool. Larger buffers are freed, so that the memory held
+	 by the pool is limited to maximumPoolSize * maximumBufferCapacity
+	 pointers.
+	 */
+	static void setMaximumBufferCapacity(size_t capacity);
+	static size_t getMaximumBufferCapacity();
+
+	static void *operator new(size_t size);
+	static void operator delete(void *ptr, size_t size);
 };
 
 /** @}*/
@@ -0,0 +1,85 @@
+#ifndef CRPROPA_DATATABLE_H
+#define CRPROPA_DATATABLE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace crpropa {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ @class DataTable
+ @brief Numeric table of a data file, loaded from a binary cache if available
+
+ The text format has one row of whitespace separated numbers per line.
+ Empty lines, lines starting with '#' and everything after a '#' are
+ ignored, rows can have different lengths.
+
+ DataTable::convert, or the tool crpropa-convert-tables, writes a binary
+ cache of a text file next to it (see DataTable::cacheName). The cache is a
+ versioned image of the parsed table that is mapped into memory with mmap,
+ so loading needs no parsing. The mapping lives as long as the DataTable:
+ the modules copy the values into their own tables, so only the page cache
+ of the file is shared between processes, not the tables. The cache is
+ only used if format version and byte order match and, if the text file
+ is present, its size and modification time are the ones of the converted
+ file. Otherwise the text file is parsed.
+ */
+class DataTable {
+public:
+	static const uint32_t formatVersion = 1;
+
+	DataTable();
+	DataTable(const std::string &filename); ///< load the table of the given text file
+	~DataTable();
+
+	/** Load the table of the given text file, from its binary cache if valid.
+	 Returns false if neither the cache nor the text file can be opened. */
+	bool load(const std::string &filename);
+	bool good() const; ///< true if a table is loaded
+	bool isMapped() const; ///< true if the table is mapped from a binary cache
+
+	size_t rows() const;
+	size_t columns(size_t row) const;
+	const double *row(size_t row) const;
+	double get(size_t row, size_t column) const;
+	size_t size() const; ///< total number of values
+	const double *data() const; ///< all values, row after row
+
+	/** Write the binary cache of a text file.
+	 @param filename	text file
+	 @param cachename	binary file, defaults to cacheName(filename)
+	 */
+	static void convert(const std::string &filename, std::string cachename = "");
+	static std::string cacheName(const std::string &filename); ///< filename + ".bin"
+	static void setUseCache(bool use); ///< disable to always parse the text files
+	static bool getUseCache();
+
+private:
+	DataTable(const DataTable &); // not copyable
+	DataTable &operator=(const DataTable &);
+
+	bool loadCache(const std::string &filename);
+	bool loadText(const std::string &filename);
+	void clear();
+
+	std::vector<double> values; // parsed text
+	std::vector<uint64_t> offsets;
+	void *mapping; // mapped cache
+	size_t mappingSize;
+	const double *valuePtr;
+	const uint64_t *offsetPtr;
+	size_t nRows;
+
+	static bool useCache;
+};
+
+/** @}*/
+} // namespace crpropa
+
+#endif // CRPROPA_DATATABLE_H
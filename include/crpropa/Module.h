@@ -4,6 +4,7 @@
 #include "crpropa/Candidate.h"
 #include "crpropa/Referenced.h"
 #include "crpropa/Common.h"
+#include "crpropa/ParticleID.h"
 
 #include <string>
 
@@ -27,6 +28,19 @@ public:
 	inline void process(ref_ptr<Candidate> candidate) const {
 		process(candidate.get());
 	}
+	/**
+	 Process n candidates in one call.
+	 The default implementation calls process for each candidate. Modules
+	 can override it to amortize the per-candidate call overhead.
+	 */
+	virtual void processBatch(Candidate **candidates, size_t n) const;
+	/**
+	 Bitmask of the ParticleClass values of the candidates this module acts
+	 on. A ModuleList skips the module for candidates of other classes.
+	 The default is ParticleClassAll. The mask must not change after the
+	 module is added to a ModuleList.
+	 */
+	virtual unsigned int getParticleClasses() const;
 };
 
 
@@ -60,6 +74,28 @@ public:
 	void setRejectFlag(std::string key, std::string value);
 	void setAcceptFlag(std::string key, std::string value);
 };
+
+/**
+ @class AbstractInteraction
+ @brief Abstract Module for stochastic interactions.
+
+ Besides processing candidates on their own, interactions expose their
+ total rate and a single interaction, so that CompetingInteractions can
+ sample several of them with one random distance per step.
+ */
+class AbstractInteraction: public Module {
+public:
+	/**
+	 Total interaction rate [1/m] per comoving distance for the current
+	 state of the candidate, 0 if the interaction does not apply.
+	 */
+	virtual double interactionRate(const Candidate *candidate) const = 0;
+	/**
+	 Perform one interaction of the candidate in its current state.
+	 Only called if interactionRate is positive.
+	 */
+	virtual void interact(Candidate *candidate) const = 0;
+};
 } // namespace crpropa
 
 #endif /* CRPROPA_MODULE_H */
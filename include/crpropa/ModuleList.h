@@ -7,6 +7,7 @@
 
 #include <list>
 #include <sstream>
+#include <vector>
 
 namespace crpropa {
 
@@ -22,24 +23,67 @@ public:
 	ModuleList();
 	virtual ~ModuleList();
 	void setShowProgress(bool show = true); ///< activate a progress bar
+	/**
+	 Propagate secondaries as OpenMP tasks in the parallel run methods.
+	 Each secondary becomes a task that idle threads can pick up, so a single
+	 large cascade is shared among all threads instead of being propagated
+	 by the thread that owns the primary.
+	 */
+	void setSecondariesAsTasks(bool tasks = true);
+	bool getSecondariesAsTasks() const;
+	/**
+	 Release secondaries as soon as they and all their own secondaries are
+	 finished. Only the unfinished secondaries along the current branch of a
+	 cascade are kept, so its memory grows with its depth instead of its
+	 size, but the secondaries of a candidate are not
+	 available anymore after ModuleList::run. Has no effect on runBatched,
+	 where finished candidates are kept until the whole batch is done.
+	 */
+	void setReleaseSecondaries(bool release = true);
+	bool getReleaseSecondaries() const;
+	/**
+	 Draw all random numbers of a candidate from its own counter-based
+	 random stream, see Random::setStream and Random::setStreamSeed.
+	 The i-th primary of a run gets the stream Random::deriveStream(0, i),
+	 secondaries get streams derived from their parent. The results are
+	 then independent of the number of threads and the scheduling, and a
+	 clone of a candidate can be re-simulated exactly with run(Candidate*).
+	 */
+	void setCounterBasedRandom(bool counterBased = true);
+	bool getCounterBasedRandom() const;
 
 	void add(Module* module);
 	void remove(std::size_t i);
 	std::size_t size() const;
 	ref_ptr<Module> operator[](const std::size_t i);
 
-	void process(Candidate* candidate) const; ///< call process in all modules
+	/**
+	 Call process in all modules that act on the class of the current
+	 particle, see Module::getParticleClasses. The class is re-evaluated
+	 whenever a module changes the particle id.
+	 */
+	void process(Candidate* candidate) const;
 	void process(ref_ptr<Candidate> candidate) const; ///< call process in all modules
+	void processBatch(Candidate **candidates, size_t n) const; ///< call processBatch in all modules with the candidates of their particle classes
 
 	void run(Candidate* candidate, bool recursive = true, bool secondariesFirst = false); ///< run simulation for a single candidate
 	void run(ref_ptr<Candidate> candidate, bool recursive = true, bool secondariesFirst = false); ///< run simulation for a single candidate
 	void run(const candidate_vector_t *candidates, bool recursive = true, bool secondariesFirst = false); ///< run simulation for a candidate vector
 	void run(SourceInterface* source, size_t count, bool recursive = true, bool secondariesFirst = false); ///< run simulation for a number of candidates from the given source
 
+	/**
+	 Run the simulation for batches of candidates.
+	 All active candidates of a batch are advanced together with processBatch.
+	 Finished candidates are removed from the batch and, if recursive,
+	 replaced by their secondaries.
+	 */
+	void runBatched(const candidate_vector_t *candidates, size_t batchSize = 256, bool recursive = true);
+	void runBatched(SourceInterface* source, size_t count, size_t batchSize = 256, bool recursive = true);
+
 	std::string getDescription() const;
 	void showModules() const;
 	
-	/** iterator goodies */
+	/** iterator goodies, modules must be added and removed with add and remove */
         typedef module_list_t::iterator iterator;
         typedef module_list_t::const_iterator const_iterator;
         iterator begin();
@@ -48,8 +92,27 @@ public:
         const_iterator end() const;
 
 private:
+	struct DispatchEntry {
+		Module *module;
+		unsigned int classes;
+	};
+
 	module_list_t modules;
+	std::vector<DispatchEntry> dispatch; ///< contiguous copy of modules with their particle classes
 	bool showProgress;
+	bool secondariesAsTasks;
+	bool releaseSecondaries;
+	bool counterBasedRandom;
+
+	void updateDispatch(); ///< rebuild the dispatch table after the modules changed
+	void processStep(Candidate* candidate) const; ///< call process, using the random stream of the candidate if enabled
+	void processBatch(Candidate **candidates, size_t n, std::vector<Candidate*> &selected) const; ///< processBatch with a scratch buffer for the selected candidates
+	void initRandomStream(Candidate* candidate, size_t i) const; ///< set the random stream of the i-th primary if enabled
+	ref_ptr<Candidate> getCandidate(SourceInterface* source, size_t i) const; ///< get the i-th primary from the source
+
+	void runTask(Candidate* candidate, bool recursive, bool secondariesFirst); ///< run a candidate, spawning its secondaries as tasks
+	void runBatch(const candidate_vector_t &batch, bool recursive); ///< advance a batch of candidates until all are finished
+	void spawnSecondaries(Candidate* candidate, size_t first, bool secondariesFirst); ///< create one task per secondary starting at index first
 };
 
 /**
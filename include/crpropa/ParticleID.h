@@ -29,6 +29,19 @@ int massNumber(int id);
 
 bool isNucleus(int id);
 
+/** Classes of particles, used to dispatch candidates only to the modules
+ that act on them, see Module::getParticleClasses.
+ */
+enum ParticleClass {
+	ParticleClassPhoton = 1, ///< photons
+	ParticleClassElectron = 2, ///< electrons and positrons
+	ParticleClassNeutrino = 4, ///< (anti-)neutrinos of all flavours
+	ParticleClassNucleus = 8, ///< nuclei, including protons and neutrons
+	ParticleClassOther = 16, ///< everything else
+	ParticleClassAll = 31
+};
+unsigned int particleClass(int id); ///< ParticleClass of the given id
+
 /* Additional modules */
 std::string convertIdToName(int id); 
 
@@ -3,6 +3,7 @@
 
 #include "crpropa/Common.h"
 #include "crpropa/Referenced.h"
+#include "crpropa/UniformLogTable.h"
 
 #include <vector>
 #include <string>
@@ -80,6 +81,11 @@ protected:
 	std::vector<double> photonDensity;
 	std::vector<double> redshifts;
 	std::vector<double> redshiftScalings;
+
+	// lookup tables of the above for getPhotonDensity and getRedshiftScaling
+	UniformLogTable densityTable;
+	UniformLogTable2D densityTable2D;
+	UniformLogTable scalingTable;
 };
 
 /**
@@ -274,8 +280,47 @@ public:
 	 @param z_in		redshift of incoming nucleon
 	 */
 	double sample_eps(bool onProton, double E_in, double z_in) const;
+
+	/**
+	 Tabulate the inverse cumulative distribution of eps over the nucleon type,
+	 E_in and z_in. sample_eps then draws eps with a lookup and a bilinear
+	 interpolation of the tabulated quantiles instead of rejection sampling,
+	 and falls back to rejection sampling outside of the table and near threshold.
+	 @param lgEmin		log10 of the minimum nucleon energy [GeV]
+	 @param lgEmax		log10 of the maximum nucleon energy [GeV]
+	 @param binsPerDecade	number of tabulation points per decade in E_in
+	 @param zMax		maximum redshift
+	 @param nRedshifts	number of tabulation points in z_in
+	 @param nQuantiles	number of tabulated quantiles of eps
+	 */
+	void initTable(double lgEmin = 6, double lgEmax = 14, int binsPerDecade = 10,
+			double zMax = 5, int nRedshifts = 21, int nQuantiles = 129);
+	bool hasTable() const;
+
+	/** Tabulated inverse cumulative distributions, see initTable */
+	struct Table: public Referenced {
+		double lgEmin, dlgE, dz;
+		size_t nE, nz, nQuantiles;
+		std::vector<char> valid; ///< cells [(type * nE + iE) * nz + iz] above threshold
+		std::vector<double> lnEps; ///< quantiles of ln(eps / eV), nQuantiles per cell
+	};
+	/** Share the table of another instance with the same photon field */
+	void setTable(ref_ptr<Table> table);
+	ref_ptr<Table> getTable() const;
 protected:
 	int bgFlag;
+	ref_ptr<Table> table;
+
+	// called by: sample_eps
+	// - input: nucleon type, energy [GeV], redshift
+	// - output: tabulated eps [eV] if (E_in, z_in) is inside of the table, else 0
+	double sampleTable(bool onProton, double E_in, double z_in) const;
+
+	// called by: initTable
+	// - input: nucleon type, energy [GeV], redshift
+	// - output: eps range [eV] and the distribution of eps as sampled by sample_eps
+	bool epsRange(bool onProton, double E_in, double z_in, double &epsMin, double &epsMax) const;
+	double epsDistribution(double eps, bool onProton, double E_in, double z_in) const;
 
 	// called by: sample_eps
 	// - input: photon energy [eV], redshift
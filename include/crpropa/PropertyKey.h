@@ -0,0 +1,55 @@
+#ifndef CRPROPA_PROPERTYKEY_H
+#define CRPROPA_PROPERTYKEY_H
+
+#include <iostream>
+#include <string>
+#include <stdint.h>
+
+namespace crpropa {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ @class PropertyKey
+ @brief Interned name of a candidate property.
+
+ The name is registered once in a global registry, which maps it to an
+ integer handle. Comparing keys then only compares the handles, so modules
+ that access a property in every step should construct the key once and
+ use it with Candidate::getProperty, Candidate::setProperty etc.
+ */
+class PropertyKey {
+	uint32_t id;
+
+	static uint32_t intern(const std::string &name);
+public:
+	PropertyKey(); ///< key of the empty name
+	explicit PropertyKey(const std::string &name);
+
+	uint32_t getId() const {
+		return id;
+	}
+	const std::string &getName() const;
+
+	bool operator==(const PropertyKey &other) const {
+		return id == other.id;
+	}
+	bool operator!=(const PropertyKey &other) const {
+		return id != other.id;
+	}
+	bool operator<(const PropertyKey &other) const {
+		return id < other.id;
+	}
+
+	/** Number of names in the registry */
+	static size_t getRegistrySize();
+};
+
+std::ostream &operator<<(std::ostream &out, const PropertyKey &key);
+
+/** @}*/
+} // namespace crpropa
+
+#endif // CRPROPA_PROPERTYKEY_H
@@ -93,6 +93,12 @@ namespace crpropa {
  Mersenne Twister random number generator -- a C++ class Random
  Based on code by Makoto Matsumoto, Takuji Nishimura, and Shawn Cokus
  Richard J. Wagner  v1.0  15 May 2003  rjwagner@writeme.com
+
+ Alternatively, the generator can be switched to a stream of the
+ counter-based Philox4x32-10 generator (Salmon et al., "Parallel random
+ numbers: as easy as 1, 2, 3", SC11) with setStream. The numbers of a
+ stream depend only on the stream seed, the stream id and the number of
+ draws, which allows reproducible results independent of the thread count.
  */
 class Random {
 public:
@@ -106,6 +112,12 @@ protected:
 	uint32_t *pNext;// next value to get from state
 	int left;// number of values left before reload needed
 
+	bool counterBased;// draw from the Philox stream instead of the Mersenne Twister
+	uint64_t stream;// id of the Philox stream
+	uint64_t counter;// number of 32-bit integers drawn from the stream
+	uint32_t block[4];// output of the Philox generator for the current block
+	static uint64_t streamSeed;// key of all Philox streams
+
 //Methods
 public:
 	/// initialize with a simple uint32_t
@@ -140,6 +152,9 @@ public:
 	double randExponential();
 	/// Normal distributed random number
 	double randNorm( const double& mean = 0.0, const double& variance = 1.0 );
+	/// Fill an array with n standard normal distributed random numbers,
+	/// using both numbers of each Box-Muller pair
+	void randNormArray(double *values, size_t n);
 	/// Uniform distribution in [min, max]
 	double randUniform(double min, double max);
 	/// Rayleigh distributed random number
@@ -201,6 +216,21 @@ public:
 	static void seedThreads(const uint32_t oneSeed);
 	static std::vector< std::vector<uint32_t> > getSeedThreads();
 
+	/// Draw the following numbers from the counter-based stream with the given id,
+	/// starting after the first counter 32-bit integers of the stream
+	void setStream(uint64_t stream, uint64_t counter = 0);
+	/// Switch back to the Mersenne Twister
+	void unsetStream();
+	bool isCounterBased() const;
+	uint64_t getStream() const;
+	/// Number of 32-bit integers drawn from the current stream
+	uint64_t getStreamCounter() const;
+	/// Seed of all counter-based streams, i.e. of the whole run
+	static void setStreamSeed(uint64_t seed);
+	static uint64_t getStreamSeed();
+	/// Id of the n-th sub-stream of a stream, e.g. for the secondaries of a candidate
+	static uint64_t deriveStream(uint64_t stream, uint64_t n);
+
 protected:
 	/// Initialize generator state with seed
 	/// See Knuth TAOCP Vol 2, 3rd Ed, p.106 for multiplier.
@@ -224,6 +254,9 @@ protected:
 	uint32_t twist( const uint32_t& m, const uint32_t& s0, const uint32_t& s1 ) const
 	{	return m ^ (mixBits(s0,s1)>>1) ^ (-loBit(s1) & 0x9908b0dfUL);}
 
+	/// Compute the Philox4x32-10 block for the current counter
+	void philox();
+
 #ifdef _MSC_VER
 #pragma warning( pop )
 #endif
@@ -0,0 +1,71 @@
+#ifndef CRPROPA_TABLEREGISTRY_H
+#define CRPROPA_TABLEREGISTRY_H
+
+#include "crpropa/Referenced.h"
+
+#include <string>
+
+namespace crpropa {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ @class TableRegistry
+ @brief Process-wide registry of interaction tables shared among modules
+
+ The interaction modules look up their tables by table kind (usually the
+ module name) and photon field name in setPhotonField, so that the tables
+ for a photon field are loaded only once per process and shared read-only
+ among all module instances and threads. The registry only keeps tables
+ that are still used by a module; the others are released on the next
+ access.
+ */
+class TableRegistry {
+public:
+	/** Get the registered tables of the given kind and photon field.
+	 Returns false if there are none or sharing is disabled. */
+	template<class T>
+	static bool find(const std::string &kind, const std::string &field, ref_ptr<T> &tables) {
+		T *t = dynamic_cast<T*>(findEntry(kind, field).get());
+		if (t == 0)
+			return false;
+		tables = t;
+		return true;
+	}
+
+	/** Register tables of the given kind and photon field. If another
+	 thread registered tables for the same key in the meantime, these are
+	 shared instead. */
+	template<class T>
+	static void insert(const std::string &kind, const std::string &field, ref_ptr<T> &tables) {
+		T *t = dynamic_cast<T*>(insertEntry(kind, field, tables.get()).get());
+		if (t != 0)
+			tables = t;
+	}
+
+	/** Give the caller its own copy of the tables before modifying them,
+	 if they are shared. Creates new tables if there are none. */
+	template<class T>
+	static void detach(ref_ptr<T> &tables) {
+		if (!tables)
+			tables = new T();
+		else if (tables->getReferenceCount() > 1)
+			tables = new T(*tables);
+	}
+
+	static size_t size(); ///< number of registered tables still in use
+	static void clear(); ///< forget all tables, modules keep their references
+	static void setEnabled(bool enabled); ///< disable to load private tables in each module
+	static bool isEnabled();
+
+private:
+	static ref_ptr<Referenced> findEntry(const std::string &kind, const std::string &field);
+	static ref_ptr<Referenced> insertEntry(const std::string &kind, const std::string &field, Referenced *tables);
+};
+
+/** @}*/
+} // namespace crpropa
+
+#endif // CRPROPA_TABLEREGISTRY_H
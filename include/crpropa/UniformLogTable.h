@@ -0,0 +1,177 @@
+#ifndef CRPROPA_UNIFORMLOGTABLE_H
+#define CRPROPA_UNIFORMLOGTABLE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace crpropa {
+/**
+ * \addtogroup Core
+ * @{
+ */
+
+/**
+ @class UniformLogAxis
+ @brief Sorted tabulation points with O(1) lookup of the enclosing interval
+
+ The spacing of the points is detected on construction. If the points are
+ equidistant in log (a leading point at 0 is allowed, as in tables that
+ start at z = 0) or linearly equidistant, the interval is computed
+ arithmetically and corrected for rounding. Otherwise it is found with a
+ binary search. The result is always the same as with std::upper_bound.
+ */
+class UniformLogAxis {
+public:
+	enum Spacing {
+		Irregular, Linear, Logarithmic
+	};
+
+	UniformLogAxis();
+	/** @param X		sorted tabulation points
+	 @param tolerance	relative tolerance for the detection of uniform spacing */
+	UniformLogAxis(const std::vector<double> &X, double tolerance = 1e-3);
+
+	const std::vector<double> &getPoints() const {
+		return X;
+	}
+	Spacing getSpacing() const {
+		return spacing;
+	}
+	size_t size() const {
+		return X.size();
+	}
+	double front() const {
+		return X.front();
+	}
+	double back() const {
+		return X.back();
+	}
+
+	/** Index i of the interval with X[i] <= x < X[i+1], clamped to
+	 [0, n-2]. Requires at least two points. */
+	size_t lowerIndex(double x) const {
+		size_t n = X.size();
+		if (spacing == Irregular) {
+			size_t i = std::upper_bound(X.begin(), X.end(), x) - X.begin();
+			return (i == 0) ? 0 : std::min(i - 1, n - 2);
+		}
+
+		double p;
+		if (spacing == Linear)
+			p = (x - start) * invStep;
+		else if (x < X[first])
+			return 0; // below the logarithmic part
+		else
+			p = (std::log(x) - start) * invStep + first;
+
+		size_t i = (p > 0) ? std::min(size_t(p), n - 2) : 0;
+		// correct rounding at the interval borders
+		while ((i > 0) and (x < X[i]))
+			i--;
+		while ((i + 2 < n) and (x >= X[i + 1]))
+			i++;
+		return i;
+	}
+
+private:
+	std::vector<double> X;
+	Spacing spacing;
+	size_t first; // first point of the logarithmic spacing
+	double start; // X[first] or log(X[first])
+	double invStep; // inverse (logarithmic) step
+};
+
+/**
+ @class UniformLogTable
+ @brief Linear interpolation table X -> Y with O(1) lookup on uniform grids
+
+ Returns the same values as crpropa::interpolate(x, X, Y), but computes
+ the interval arithmetically if X is tabulated on an equidistant log10 (or
+ linear) grid, see UniformLogAxis.
+ */
+class UniformLogTable {
+public:
+	UniformLogTable();
+	UniformLogTable(const std::vector<double> &X, const std::vector<double> &Y);
+
+	const UniformLogAxis &getAxis() const {
+		return axis;
+	}
+	const std::vector<double> &getValues() const {
+		return Y;
+	}
+	bool empty() const {
+		return Y.empty();
+	}
+
+	/** Linear interpolation, returns Y[0] if x < X[0] and Y[n-1] if x > X[n-1] */
+	double interpolate(double x) const {
+		if (x <= axis.front())
+			return Y.front();
+		if (x >= axis.back())
+			return Y.back();
+		const std::vector<double> &X = axis.getPoints();
+		size_t i = axis.lowerIndex(x);
+		return Y[i] + (x - X[i]) * (Y[i + 1] - Y[i]) / (X[i + 1] - X[i]);
+	}
+
+private:
+	UniformLogAxis axis;
+	std::vector<double> Y;
+};
+
+/**
+ @class UniformLogTable2D
+ @brief Bilinear interpolation table (X, Y) -> Z with O(1) lookup on uniform grids
+
+ Returns the same values as crpropa::interpolate2d(x, y, X, Y, Z) with
+ Z[j + i * Y.size()] the value at (X[i], Y[j]).
+ */
+class UniformLogTable2D {
+public:
+	UniformLogTable2D();
+	UniformLogTable2D(const std::vector<double> &X, const std::vector<double> &Y,
+			const std::vector<double> &Z);
+
+	bool empty() const {
+		return Z.empty();
+	}
+
+	/** Bilinear interpolation, returns 0 outside of the tabulated range */
+	double interpolate(double x, double y) const {
+		if ((x > xAxis.back()) or (x < xAxis.front()))
+			return 0;
+		if ((y > yAxis.back()) or (y < yAxis.front()))
+			return 0;
+
+		const std::vector<double> &X = xAxis.getPoints();
+		const std::vector<double> &Y = yAxis.getPoints();
+		size_t i = xAxis.lowerIndex(x);
+		size_t j = yAxis.lowerIndex(y);
+		size_t ny = Y.size();
+
+		double Q11 = Z[j + i * ny];
+		double Q12 = Z[j + 1 + i * ny];
+		double Q21 = Z[j + (i + 1) * ny];
+		double Q22 = Z[j + 1 + (i + 1) * ny];
+
+		double dx = X[i + 1] - X[i];
+		double R1 = ((X[i + 1] - x) / dx) * Q11 + ((x - X[i]) / dx) * Q21;
+		double R2 = ((X[i + 1] - x) / dx) * Q12 + ((x - X[i]) / dx) * Q22;
+
+		double dy = Y[j + 1] - Y[j];
+		return ((Y[j + 1] - y) / dy) * R1 + ((y - Y[j]) / dy) * R2;
+	}
+
+private:
+	UniformLogAxis xAxis;
+	UniformLogAxis yAxis;
+	std::vector<double> Z;
+};
+
+/** @}*/
+} // namespace crpropa
+
+#endif // CRPROPA_UNIFORMLOGTABLE_H
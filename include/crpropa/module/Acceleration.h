@@ -148,7 +148,7 @@ class ParticleSplitting : public Module {
 	int crossingThreshold;
 	double minWeight;
 	ref_ptr<Surface> surface;
-	std::string counterid;
+	PropertyKey counterid;
 
 	public:
 	/// @params surface               The surface to monitor
@@ -165,6 +165,10 @@ class ParticleSplitting : public Module {
 
 	// update the candidate
 	void process(Candidate *candidate) const;
+
+	/// Split the candidate into numSplits candidates of equal weight. The
+	/// copies are added as secondaries of the candidate.
+	static void split(Candidate *candidate, int numSplits);
 };
 
 
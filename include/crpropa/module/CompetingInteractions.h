@@ -0,0 +1,76 @@
+#ifndef CRPROPA_COMPETINGINTERACTIONS_H
+#define CRPROPA_COMPETINGINTERACTIONS_H
+
+#include "crpropa/Module.h"
+#include "crpropa/PropertyKey.h"
+
+#include <vector>
+
+namespace crpropa {
+/**
+ * \addtogroup EnergyLosses
+ * @{
+ */
+
+/**
+ @class CompetingInteractions
+ @brief Samples a set of interactions with one random distance per step
+
+ Each step the rates of all interactions acting on the candidate are
+ evaluated once. A single exponential distance is drawn from the total rate
+ and the interaction is selected in proportion to its rate. If no
+ interaction happens within the step, the next step is limited to a
+ fraction of the total mean free path.
+
+ In the event-driven mode the distance to the next interaction is sampled
+ once as an optical depth and kept in the candidate (properties
+ "InteractionDepth" and "InteractionDepthSerial", the latter binding it to
+ the serial number so that clones and secondaries draw their own). Each
+ step consumes the optical depth with the total rate and the next step is
+ limited to exactly the remaining distance, so that the candidate jumps to
+ its next interaction instead of stepping by fractions of the mean free
+ path. See also the event-driven neutral stepping of the propagation
+ modules (e.g. PropagationCK::setEventDrivenNeutrals).
+
+ Add the interactions to this module instead of the ModuleList, and add all
+ of them before this module is added to a ModuleList.
+ */
+class CompetingInteractions: public Module {
+private:
+	struct Channel {
+		ref_ptr<AbstractInteraction> interaction;
+		unsigned int particleClasses;
+	};
+	std::vector<Channel> channels;
+	unsigned int particleClasses;
+	double limit;
+	bool eventDriven;
+	PropertyKey depthKey, serialKey;
+
+	void processEventDriven(Candidate *candidate) const;
+
+public:
+	static const size_t maxInteractions = 32;
+
+	/** Constructor
+	 @param limit	fraction of the total mean free path to limit the next step
+	 */
+	CompetingInteractions(double limit = 0.1);
+	void add(AbstractInteraction *interaction);
+	size_t size() const;
+	AbstractInteraction *get(size_t i) const;
+	void setLimit(double limit);
+	double getLimit() const;
+	/** Sample the distance to the next interaction once and step exactly to it */
+	void setEventDriven(bool eventDriven);
+	bool isEventDriven() const;
+
+	void process(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
+	std::string getDescription() const;
+};
+/** @}*/
+
+} // namespace crpropa
+
+#endif // CRPROPA_COMPETINGINTERACTIONS_H
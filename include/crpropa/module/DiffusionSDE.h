@@ -29,6 +29,10 @@ namespace crpropa {
  * Here an Euler-Mayurama integration scheme is used. The diffusion tensor
  * can be anisotropic with respect to the magnetic field line coordinates.
  * The integration of field lines is done via the CK-algorithm.
+ * processBatch integrates the field lines of batchWidth pseudo-particles together
+ * in structure-of-arrays layout. The normal variates of a batch are drawn in one
+ * call and each pseudo-particle halves its own time step until the tolerance is
+ * reached. The results agree statistically with process.
  */
 
 
@@ -46,6 +50,8 @@ private:
 
 
 public:
+	    static const size_t batchWidth = 8; // number of pseudo-particles integrated together by processBatch
+
 /** Constructor
 	@param minStep		minStep/c_light is the minimum integration timestep
 	@param maxStep		maxStep/c_light is the maximum integration timestep
@@ -59,6 +65,7 @@ public:
 	    DiffusionSDE(ref_ptr<crpropa::MagneticField> magneticField, ref_ptr<crpropa::AdvectionField> advectionField, double tolerance = 1e-4, double minStep=(10*pc), double maxStep=(1*kpc), double epsilon=0.1);
 
 	    void process(crpropa::Candidate *candidate) const;
+	    void processBatch(crpropa::Candidate **candidates, size_t n) const;
 
 	    void tryStep(const Vector3d &Pos, Vector3d &POut, Vector3d &PosErr, double z, double propStep ) const;
 	    void driftStep(const Vector3d &Pos, Vector3d &LinProp, double h) const;
@@ -81,6 +88,15 @@ public:
 	    double getScale() const;
 	    std::string getDescription() const;
 
+private:
+	    // advance up to batchWidth charged pseudo-particles together
+	    void processLanes(Candidate **candidates, size_t n) const;
+	    // Cash-Karp step along the field lines of the active lanes
+	    void tryStepLanes(const double PosIn[3][batchWidth], double POut[3][batchWidth], double PosErr[3][batchWidth],
+	    		const double z[batchWidth], const double propStep[batchWidth], const bool active[batchWidth]) const;
+	    // perpendicular diffusion, advection and the next step after the field line integration
+	    void finishStep(Candidate *candidate, const Vector3d &PosIn, const Vector3d &PosOut,
+	    		double h, double TStep, double NStep, double BStep, size_t stepNumber) const;
 };
 /** @}*/
 
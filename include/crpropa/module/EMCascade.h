@@ -3,22 +3,35 @@
 
 #include "crpropa/Module.h"
 
+#include <vector>
+
 namespace crpropa {
 
 /**
  @class EMCascade
  @brief Collects and deactivates photons, electrons and positrons. Uses DINT to calculate the EM cascade.
+
+ The particles are binned in energy and in their distance to the origin,
+ which is assumed to be the observer, weighted with the candidate weight.
+ For a hybrid simulation, set a maximum energy below which the particles
+ are handed off to DINT, and add this module before the EM interactions.
+ The 3D Monte Carlo then only tracks the high-energy part of the cascade,
+ and runCascade solves the transport of the collected low-energy part in
+ one call at the end of the run. Each thread fills its own histograms,
+ which are summed by save and runCascade.
  */
 class EMCascade: public Module {
 private:
 	// energy and distance binning
 	int nE, nD;
 	double logEmin, logEmax, dlogE, Dmax, dD;
+	double maximumEnergy; // particles above are not collected
 
-	// histograms (distance,energy) of photons, electrons and positrons
-	mutable std::vector<uint64_t> photonHist;
-	mutable std::vector<uint64_t> electronHist;
-	mutable std::vector<uint64_t> positronHist;
+	// weighted histograms (species, distance, energy) of photons, electrons
+	// and positrons, one per thread
+	mutable std::vector<std::vector<double> > histograms;
+	std::vector<double> &threadHistogram() const;
+	std::vector<double> sumHistograms() const;
 	void init();
 
 public:
@@ -30,8 +43,13 @@ public:
 		int nD        //!< number of distance bins
 		);
 
+	/** Collect only particles below this energy, the others are left active */
+	void setMaximumEnergy(double energy);
+	double getMaximumEnergy() const;
+
 	/** Collect and deactivate photons, electrons and positrons */
 	void process(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 
 	/** Save the unpropagated histogram of EM particles */
 	void save(const std::string &filename);
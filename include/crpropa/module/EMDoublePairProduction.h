@@ -6,6 +6,7 @@
 
 #include "crpropa/Module.h"
 #include "crpropa/PhotonBackground.h"
+#include "crpropa/UniformLogTable.h"
 
 namespace crpropa {
 
@@ -20,16 +21,21 @@ namespace crpropa {
  For the maximum thinning of 1, only a few representative particles are added to the list of secondaries.
  Note that for thinning>0 the output must contain the column "weights", which should be included in the post-processing.
  */
-class EMDoublePairProduction: public Module {
+class EMDoublePairProduction: public AbstractInteraction {
 private:
 	ref_ptr<PhotonField> photonField;
 	bool haveElectrons;
 	double limit;
 	double thinning;
 
-	// tabulated interaction rate 1/lambda(E)
-	std::vector<double> tabEnergy;  //!< electron energy in [J]
-	std::vector<double> tabRate;  //!< interaction rate in [1/m]
+	// tabulated data, shared among all instances for the same photon field
+	struct Tables: public Referenced {
+		// tabulated interaction rate 1/lambda(E)
+		std::vector<double> tabEnergy;  //!< electron energy in [J]
+		std::vector<double> tabRate;  //!< interaction rate in [1/m]
+		UniformLogTable rate;  //!< tabRate(tabEnergy) with O(1) lookup
+	};
+	ref_ptr<Tables> tables;
 
 public:
 	EMDoublePairProduction(
@@ -46,6 +52,9 @@ public:
 
 	void initRate(std::string filename);
 	void process(Candidate *candidate) const;
+	double interactionRate(const Candidate *candidate) const;
+	void interact(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 	void performInteraction(Candidate *candidate) const;
 
 };
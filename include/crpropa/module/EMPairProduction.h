@@ -6,6 +6,8 @@
 
 #include "crpropa/Module.h"
 #include "crpropa/PhotonBackground.h"
+#include "crpropa/UniformLogTable.h"
+#include "crpropa/AliasTable.h"
 
 
 namespace crpropa {
@@ -22,21 +24,27 @@ namespace crpropa {
  For the maximum thinning of 1, only a few representative particles are added to the list of secondaries.
  Note that for thinning>0 the output must contain the column "weights", which should be included in the post-processing.
  */
-class EMPairProduction: public Module {
+class EMPairProduction: public AbstractInteraction {
 private:
 	ref_ptr<PhotonField> photonField;
 	bool haveElectrons;
 	double limit;
 	double thinning;
 
-	// tabulated interaction rate 1/lambda(E)
-	std::vector<double> tabEnergy;  //!< electron energy in [J]
-	std::vector<double> tabRate;  //!< interaction rate in [1/m]
-	
-	// tabulated CDF(s_kin, E) = cumulative differential interaction rate
-	std::vector<double> tabE;  //!< electron energy in [J]
-	std::vector<double> tabs;  //!< s_kin = s - m^2 in [J**2]
-	std::vector< std::vector<double> > tabCDF;  //!< cumulative interaction rate
+	// tabulated data, shared among all instances for the same photon field
+	struct Tables: public Referenced {
+		// tabulated interaction rate 1/lambda(E)
+		std::vector<double> tabEnergy;  //!< electron energy in [J]
+		std::vector<double> tabRate;  //!< interaction rate in [1/m]
+		UniformLogTable rate;  //!< tabRate(tabEnergy) with O(1) lookup
+
+		// tabulated CDF(s_kin, E) = cumulative differential interaction rate
+		std::vector<double> tabE;  //!< electron energy in [J]
+		std::vector<double> tabs;  //!< s_kin = s - m^2 in [J**2]
+		std::vector< std::vector<double> > tabCDF;  //!< cumulative interaction rate
+		AliasTable sBins;  //!< alias tables of tabCDF for drawing s_kin bins
+	};
+	ref_ptr<Tables> tables;
 
 public:
 	EMPairProduction(
@@ -56,6 +64,9 @@ public:
 
 	void performInteraction(Candidate *candidate) const;
 	void process(Candidate *candidate) const;
+	double interactionRate(const Candidate *candidate) const;
+	void interact(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 };
 
 } // namespace crpropa
@@ -12,12 +12,16 @@ namespace crpropa {
  @class ElasticScattering
  @brief Elastic scattering of background photons on cosmic ray nuclei.
  */
-class ElasticScattering: public Module {
+class ElasticScattering: public AbstractInteraction {
 private:
     ref_ptr<PhotonField> photonField;
 
-    std::vector<double> tabRate; // elastic scattering rate
-    std::vector<std::vector<double> > tabCDF; // CDF as function of background photon energy
+    // tabulated data, shared among all instances for the same photon field
+    struct Tables: public Referenced {
+        std::vector<double> tabRate; // elastic scattering rate
+        std::vector<std::vector<double> > tabCDF; // CDF as function of background photon energy
+    };
+    ref_ptr<Tables> tables;
 
     static const double lgmin; // minimum log10(Lorentz-factor)
     static const double lgmax; // maximum log10(Lorentz-factor)
@@ -32,6 +36,9 @@ public:
     void initCDF(std::string filename);
     void setPhotonField(ref_ptr<PhotonField> photonField);
     void process(Candidate *candidate) const;
+    double interactionRate(const Candidate *candidate) const;
+    void interact(Candidate *candidate) const;
+    unsigned int getParticleClasses() const;
 };
 
 } // namespace crpropa
@@ -3,6 +3,7 @@
 
 #include "crpropa/Module.h"
 #include "crpropa/PhotonBackground.h"
+#include "crpropa/UniformLogTable.h"
 
 namespace crpropa {
 
@@ -18,15 +19,22 @@ namespace crpropa {
  This module simulates electron-pair production as a continuous energy loss.\n
  Several photon fields can be selected.\n
  The production of secondary e+/e- pairs and photons can by activated.\n
- By default, the module limits the step size to 10% of the energy loss length of the particle.
+ By default, the module limits the step size to 10% of the energy loss length of the particle.\n
+ Thinning of the secondary pairs is available, see setThinning.
  */
 class ElectronPairProduction: public Module {
 private:
 	ref_ptr<PhotonField> photonField;
-	std::vector<double> tabLossRate; /*< tabulated energy loss rate in [J/m] for protons at z = 0 */
-	std::vector<double> tabLorentzFactor; /*< tabulated Lorentz factor */
-	std::vector<std::vector<double> > tabSpectrum; /*< electron/positron cdf(Ee|log10(gamma)) for log10(Ee/eV)=7-24 in 170 steps and log10(gamma)=6-13 in 70 steps and*/
+	// tabulated data, shared among all instances for the same photon field
+	struct Tables: public Referenced {
+		std::vector<double> tabLossRate; /*< tabulated energy loss rate in [J/m] for protons at z = 0 */
+		std::vector<double> tabLorentzFactor; /*< tabulated Lorentz factor */
+		UniformLogTable lossRate; /*< tabLossRate(tabLorentzFactor) with O(1) lookup */
+		std::vector<std::vector<double> > tabSpectrum; /*< electron/positron cdf(Ee|log10(gamma)) for log10(Ee/eV)=7-24 in 170 steps and log10(gamma)=6-13 in 70 steps and*/
+	};
+	ref_ptr<Tables> tables;
 	double limit; ///< fraction of energy loss length to limit the next step
+	double thinning; ///< weighted sampling of secondary pairs
 	bool haveElectrons;
 
 public:
@@ -36,10 +44,22 @@ public:
 	void setPhotonField(ref_ptr<PhotonField> photonField);
 	void setHaveElectrons(bool haveElectrons);
 	void setLimit(double limit);
+	/**
+	 Weighted sampling of the secondary pairs.
+	 A pair of energy Epair is kept with probability (Epair / dE)^thinning,
+	 with dE the energy lost to pair production in the step, and its weight
+	 is increased accordingly. A thinning of 0 means that all pairs are
+	 tracked; for the maximum thinning of 1 about one representative pair is
+	 emitted per step. The weighted energy of the pairs equals dE on average.
+	 Only the number of emitted secondaries is reduced: all pairs of the step
+	 are still drawn, so the sampling cost per step stays the same.
+	 */
+	void setThinning(double thinning);
 
 	void initRate(std::string filename);
 	void initSpectrum(std::string filename);
 	void process(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 
 	/**
 	 Calculates the energy loss length 1/beta = -E dx/dE in [m]
@@ -21,9 +21,10 @@ namespace crpropa {
 
  For details on the preprocessing of the NuDat2 data refer to "CRPropa3-data/calc_decay.py".
  */
-class NuclearDecay: public Module {
+class NuclearDecay: public AbstractInteraction {
 private:
 	double limit;
+	double instantDecay;
 	bool haveElectrons;
 	bool havePhotons;
 	bool haveNeutrinos;
@@ -34,14 +35,28 @@ private:
 		std::vector<double> intensity; // probabilities of ensuing gamma decays
 	};
 	std::vector<std::vector<DecayMode> > decayTable; // decayTable[Z * 31 + N] = vector<DecayMode>
+	std::vector<double> decayRate; // decayRate[Z * 31 + N] = total decay rate in [1/m] at rest
 
 public:
 	NuclearDecay(bool electrons = false, bool photons = false, bool neutrinos = false, double limit = 0.1);
 	void setLimit(double limit);
+	/**
+	 Resolve decay chains of short-lived nuclei in a single jump.
+	 Nuclei whose mean decay length is below the given fraction of the
+	 current step decay at once, without drawing a decay distance or
+	 limiting the next step, until a nucleus is reached that is long-lived
+	 on the scale of the step. Disabled for 0 (default).
+	 @param fraction	fraction of the current step
+	 */
+	void setInstantDecay(double fraction);
+	double getInstantDecay() const;
 	void setHaveElectrons(bool b);
 	void setHavePhotons(bool b);
 	void setHaveNeutrinos(bool b);
 	void process(Candidate *candidate) const;
+	double interactionRate(const Candidate *candidate) const;
+	void interact(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 	void performInteraction(Candidate *candidate, int channel) const;
 	void gammaEmission(Candidate *candidate, int channel) const;
 	void betaDecay(Candidate *candidate, bool isBetaPlus) const;
@@ -22,6 +22,7 @@ protected:
 	struct Property
 	{
 		std::string name;
+		PropertyKey key;
 		std::string comment;
 		Variant defaultValue;
 	};
@@ -17,15 +17,19 @@ namespace crpropa {
  @class PhotoDisintegration
  @brief Photodisintegration of nuclei by background photons.
  */
-class PhotoDisintegration: public Module {
+class PhotoDisintegration: public AbstractInteraction {
 private:
 	ref_ptr<PhotonField> photonField;
 	double limit; // fraction of mean free path for limiting the next step
 	bool havePhotons;
 
-	struct Branch {
-		int channel; // number of emitted (n, p, H2, H3, He3, He4)
-		std::vector<double> branchingRatio; // branching ratio as function of nucleus Lorentz factor
+	// position of the tabulated data of an isotope in the flat tables
+	struct Isotope {
+		size_t rate; // first of nlg rates in pdRate, npos if not tabulated
+		size_t branch; // first channel in pdChannel
+		size_t nBranch; // number of channels
+		Isotope();
+		static const size_t npos = size_t(-1);
 	};
 
 	struct PhotonEmission {
@@ -33,14 +37,23 @@ private:
 		std::vector<double> emissionProbability; // emission probability as function of nucleus Lorentz factor
 	};
 
-	std::vector<std::vector<double> > pdRate; // pdRate[Z * 31 + N] = total interaction rate
-	std::vector<std::vector<Branch> > pdBranch; // pdTable[Z * 31 + N] = branching ratios
-	mutable std::map<int, std::vector<PhotonEmission> > pdPhoton; // map of emitted photon energies and photon emission probabilities
+	// tabulated data, shared among all instances for the same photon field
+	struct Tables: public Referenced {
+		std::vector<Isotope> isotopes; // isotopes[Z * 31 + N]
+		std::vector<double> pdRate; // total interaction rate, (isotope, Lorentz factor)
+		std::vector<int> pdChannel; // number of emitted (n, p, H2, H3, He3, He4), (isotope, channel)
+		std::vector<double> pdBranch; // cumulative branching ratio, (isotope, Lorentz factor, channel)
+		std::map<int, std::vector<PhotonEmission> > pdPhoton; // map of emitted photon energies and photon emission probabilities
+	};
+	ref_ptr<Tables> tables;
 
 	static const double lgmin; // minimum log10(Lorentz-factor)
 	static const double lgmax; // maximum log10(Lorentz-factor)
 	static const size_t nlg; // number of Lorentz-factor steps
 
+	const Isotope *findIsotope(int id) const; // 0 if not tabulated
+	static double interpolateTable(double lg, const double *Y); // Y tabulated at nlg Lorentz factors
+
 public:
 	PhotoDisintegration(ref_ptr<PhotonField> photonField, bool havePhotons = false, double limit = 0.1);
 
@@ -53,6 +66,9 @@ public:
 	void initPhotonEmission(std::string filename);
 
 	void process(Candidate *candidate) const;
+	double interactionRate(const Candidate *candidate) const;
+	void interact(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 	void performInteraction(Candidate *candidate, int channel) const;
 
 	/**
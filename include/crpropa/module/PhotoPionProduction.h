@@ -3,7 +3,10 @@
 
 #include "crpropa/Module.h"
 #include "crpropa/PhotonBackground.h"
+#include "crpropa/UniformLogTable.h"
+#include "crpropa/Random.h"
 
+#include <stdint.h>
 #include <vector>
 
 namespace crpropa {
@@ -18,18 +21,71 @@ struct SophiaEventOutput {
 	std::vector<int> id;
 };
 
+/**
+ @class PhotoPionEventLibrary
+ @brief Tabulated SOPHIA final states for sampling photo-pion events without a lock
+
+ For ultra-relativistic nucleons the energy fractions E_i / E_in of the final
+ state particles only depend on the invariant E_in * eps. The library holds
+ SOPHIA events for protons and neutrons in bins of log10(E_in * eps); an
+ event is drawn from the bin of the requested interaction and its energy
+ fractions are scaled to E_in. Sampling is read-only and can be done
+ concurrently by all threads.
+ */
+class PhotoPionEventLibrary: public Referenced {
+public:
+	/** Generate the library with SOPHIA.
+	 @param eventsPerBin	number of events per bin and nucleon type
+	 @param binsPerDecade	number of bins per decade in E_in * eps
+	 */
+	PhotoPionEventLibrary(size_t eventsPerBin = 200, size_t binsPerDecade = 20);
+
+	/** Draw an event for a nucleon of energy Ein interacting with a photon of
+	 energy eps. Returns false if E_in * eps is outside of the library,
+	 otherwise the particles of the event are the indices [first, last). */
+	bool sample(bool onProton, double Ein, double eps, Random &random,
+			size_t &first, size_t &last) const;
+	/// SOPHIA id of particle i
+	int getId(size_t i) const {
+		return id[i];
+	}
+	/// energy of particle i / E_in
+	double getEnergyFraction(size_t i) const {
+		return fraction[i];
+	}
+	size_t getEventsPerBin() const;
+	size_t getBinsPerDecade() const;
+
+private:
+	size_t eventsPerBin;
+	size_t binsPerDecade;
+	size_t nBins;
+	std::vector<size_t> offsets; // first particle of each event, nucleon type major
+	std::vector<int8_t> id;
+	std::vector<float> fraction;
+};
+
 /**
  @class PhotoPionProduction
  @brief Photo-pion interactions of nuclei with background photons.
  */
-class PhotoPionProduction: public Module {
+class PhotoPionProduction: public AbstractInteraction {
 protected:
 	ref_ptr<PhotonField> photonField;
 	PhotonFieldSampling photonFieldSampling;
-	std::vector<double> tabLorentz; ///< Lorentz factor of nucleus
-	std::vector<double> tabRedshifts;  ///< redshifts (optional for haveRedshiftDependence)
-	std::vector<double> tabProtonRate; ///< interaction rate in [1/m] for protons
-	std::vector<double> tabNeutronRate; ///< interaction rate in [1/m] for neutrons
+	/// tabulated data, shared among all instances for the same photon field
+	struct Tables: public Referenced {
+		std::vector<double> tabLorentz; ///< Lorentz factor of nucleus
+		std::vector<double> tabRedshifts;  ///< redshifts (optional for haveRedshiftDependence)
+		std::vector<double> tabProtonRate; ///< interaction rate in [1/m] for protons
+		std::vector<double> tabNeutronRate; ///< interaction rate in [1/m] for neutrons
+		UniformLogTable protonRate; ///< tabProtonRate(tabLorentz) with O(1) lookup
+		UniformLogTable neutronRate; ///< tabNeutronRate(tabLorentz) with O(1) lookup
+		UniformLogTable2D protonRate2D; ///< tabProtonRate(tabRedshifts, tabLorentz) for haveRedshiftDependence
+		UniformLogTable2D neutronRate2D; ///< tabNeutronRate(tabRedshifts, tabLorentz) for haveRedshiftDependence
+	};
+	ref_ptr<Tables> tables;
+	ref_ptr<PhotoPionEventLibrary> eventLibrary; ///< optional, used instead of SOPHIA
 	double limit; ///< fraction of mean free path to limit the next step
 	bool havePhotons;
 	bool haveNeutrinos;
@@ -53,10 +109,28 @@ public:
 	void setHaveAntiNucleons(bool b);
 	void setHaveRedshiftDependence(bool b);
 	void setLimit(double limit);
+	/** Sample the final states from a library of SOPHIA events instead of
+	 calling SOPHIA, which has to be serialized among the threads.
+	 The library is generated on the first call and shared among all modules.
+	 Interactions outside of the library fall back to SOPHIA.
+	 @param use				use the event library
+	 @param eventsPerBin	number of events per bin in E_in * eps and nucleon type
+	 */
+	void setEventLibrary(bool use, size_t eventsPerBin = 200);
+	bool getEventLibrary() const;
+	/** Draw the energy of the target photon from a tabulated inverse
+	 cumulative distribution instead of rejection sampling, see
+	 PhotonFieldSampling::initTable. The table is built on the first call
+	 and shared among all modules with the same photon field. */
+	void setTabulatedPhotonSampling(bool use);
+	bool getTabulatedPhotonSampling() const;
 	void initRate(std::string filename);
 	double nucleonMFP(double gamma, double z, bool onProton) const;
 	double nucleiModification(int A, int X) const;
 	void process(Candidate *candidate) const;
+	double interactionRate(const Candidate *candidate) const;
+	void interact(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 	void performInteraction(Candidate *candidate, bool onProton) const;
 
 	/**
@@ -69,7 +143,7 @@ public:
 	double lossLength(int id, double gamma, double z = 0);
 
 	/**
-	 Direct SOPHIA interface.
+	 Direct SOPHIA interface, serialized among the threads.
 	 Output is an object SophiaEventOutput with two vectors "energy" and "id" each of length N (number of out-going particles).
 	 The i-th component of each vector corresponds to the same particle.
 	 This is not used in the simulation.
@@ -25,6 +25,7 @@ public:
 	PhotonEleCa(const std::string background, const std::string &outputFilename);
 	~PhotonEleCa();
 	void process(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 	std::string getDescription() const;
 	void setObserver(const Vector3d &position);
 	void setSaveOnlyPhotonEnergies(bool photonsOnly);
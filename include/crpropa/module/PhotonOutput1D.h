@@ -23,6 +23,7 @@ public:
 	PhotonOutput1D(const std::string &filename);
 	~PhotonOutput1D();
 	void process(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 	std::string getDescription() const;
 	void close();
 	void gzip();
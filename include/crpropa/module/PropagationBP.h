@@ -56,6 +56,7 @@ private:
 	double tolerance; /** target relative error of the numerical integration */
 	double minStep; /** minimum step size of the propagation */
 	double maxStep; /** maximum step size of the propagation */
+	bool eventDrivenNeutrals; /** neutral particles step by the limits of the other modules only */
 
 public:
 	/** Default constructor for the Boris push. It is constructed with a fixed step size.
@@ -122,6 +123,9 @@ public:
 	/** set the maximum step for the Boris push
 	 * @param maxStep	   maxStep/c_light is the maximum integration time step */
 	void setMaximumStep(double maxStep);
+	/** Event-driven stepping of neutral particles, see propagateNeutral */
+	void setEventDrivenNeutrals(bool eventDriven);
+	bool isEventDrivenNeutrals() const;
 
 	 /** get functions for the parameters of the class PropagationBP, similar to the set functions */
 	ref_ptr<MagneticField> getField() const;
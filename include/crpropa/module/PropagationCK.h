@@ -19,7 +19,12 @@ namespace crpropa {
  It uses the Runge-Kutta integration method with Cash-Karp coefficients.\n
  The step size control tries to keep the relative error close to, but smaller than the designated tolerance.
  Additionally a minimum and maximum size for the steps can be set.
- For neutral particles a rectilinear propagation is applied and a next step of the maximum step size proposed.
+ For neutral particles a rectilinear propagation is applied and a next step of the maximum step size proposed,
+ or an unlimited one in the event-driven mode (setEventDrivenNeutrals).
+ processBatch advances batchWidth charged candidates together with the phase points in
+ structure-of-arrays layout, so that the arithmetic of the Runge-Kutta stages vectorizes
+ (see the SIMD_EXTENSIONS build option). Each candidate keeps its own adaptive step:
+ candidates whose step is accepted are masked out while the others retry.
  */
 class PropagationCK: public Module {
 public:
@@ -55,11 +60,18 @@ private:
 	double tolerance; /*< target relative error of the numerical integration */
 	double minStep; /*< minimum step size of the propagation */
 	double maxStep; /*< maximum step size of the propagation */
+	bool eventDrivenNeutrals; /*< neutral particles step by the limits of the other modules only */
+
+	// advance up to batchWidth charged candidates together
+	void processLanes(Candidate **candidates, size_t n) const;
 
 public:
+	static const size_t batchWidth = 4; /*< number of candidates integrated together by processBatch */
+
 	PropagationCK(ref_ptr<MagneticField> field = NULL, double tolerance = 1e-4,
 			double minStep = (0.1 * kpc), double maxStep = (1 * Gpc));
 	void process(Candidate *candidate) const;
+	void processBatch(Candidate **candidates, size_t n) const;
 
 	// derivative of phase point, dY/dt = d/dt(x, u) = (v, du/dt)
 	// du/dt = q*c^2/E * (u x B)
@@ -72,6 +84,9 @@ public:
 	void setTolerance(double tolerance);
 	void setMinimumStep(double minStep);
 	void setMaximumStep(double maxStep);
+	/** Event-driven stepping of neutral particles, see propagateNeutral */
+	void setEventDrivenNeutrals(bool eventDriven);
+	bool isEventDrivenNeutrals() const;
 
 	double getTolerance() const;
 	double getMinimumStep() const;
@@ -0,0 +1,121 @@
+#ifndef CRPROPA_PROPAGATIONDP_H
+#define CRPROPA_PROPAGATIONDP_H
+
+#include "crpropa/Module.h"
+#include "crpropa/Units.h"
+#include "crpropa/magneticField/MagneticField.h"
+
+#include <vector>
+
+namespace crpropa {
+/**
+ * \addtogroup Propagation
+ * @{
+ */
+
+/**
+ @class PropagationDP
+ @brief Rectilinear propagation through magnetic fields using the Dormand-Prince method.
+
+ This module solves the equations of motion of a relativistic charged particle when propagating through a magnetic field.\n
+ It uses the Runge-Kutta integration method of order 5(4) with Dormand-Prince coefficients.\n
+ The last stage of a step is evaluated at the end point of the step (first same as last).
+ Its magnetic field is kept in a small per-thread cache and reused for the first stage of the next step of
+ the candidate, if the candidate has not been moved in between. The first stage is also reused when a step
+ is retried. Each attempted step thus needs six field evaluations, and the smaller error constants allow
+ larger steps than the Cash-Karp method for the same tolerance.
+ The step size control tries to keep the relative error close to, but smaller than the designated tolerance.
+ Additionally a minimum and maximum size for the steps can be set.
+ For neutral particles a rectilinear propagation is applied and a next step of the maximum step size proposed,
+ or an unlimited one in the event-driven mode (setEventDrivenNeutrals).
+ */
+class PropagationDP: public Module {
+public:
+	class Y {
+	public:
+		Vector3d x, u; /*< phase-point: position and direction */
+
+		Y() {
+		}
+
+		Y(const Vector3d &x, const Vector3d &u) :
+				x(x), u(u) {
+		}
+
+		Y(double f) :
+				x(Vector3d(f, f, f)), u(Vector3d(f, f, f)) {
+		}
+
+		Y operator *(double f) const {
+			return Y(x * f, u * f);
+		}
+
+		Y &operator +=(const Y &y) {
+			x += y.x;
+			u += y.u;
+			return *this;
+		}
+	};
+
+private:
+	std::vector<double> a, b, e; /*< Dormand-Prince coefficients and error weights */
+	ref_ptr<MagneticField> field;
+	double tolerance; /*< target relative error of the numerical integration */
+	double minStep; /*< minimum step size of the propagation */
+	double maxStep; /*< maximum step size of the propagation */
+	bool eventDrivenNeutrals; /*< neutral particles step by the limits of the other modules only */
+
+	// magnetic field at the end point of the last step of a candidate,
+	// kept in a thread_local cache shared by all instances
+	struct CachedField {
+		uint64_t fieldVersion;
+		const Candidate *candidate;
+		Vector3d position;
+		double z;
+		Vector3d field;
+	};
+	uint64_t fieldVersion; /*< identifies the module and field of the cached fields, renewed by setField */
+	CachedField &cacheEntry(const Candidate *candidate) const;
+	Vector3d getFieldAtPosition(const Vector3d &pos, double z) const;
+
+public:
+	PropagationDP(ref_ptr<MagneticField> field = NULL, double tolerance = 1e-4,
+			double minStep = (0.1 * kpc), double maxStep = (1 * Gpc));
+	void process(Candidate *candidate) const;
+
+	// derivative of phase point, dY/dt = d/dt(x, u) = (v, du/dt)
+	// du/dt = q*c^2/E * (u x B), for the magnetic field B at y.x
+	Y dYdt(const Y &y, ParticleState &p, const Vector3d &B) const;
+
+	/** Dormand-Prince step
+	 @param y		phase point at the start of the step
+	 @param k0		derivative at the start of the step
+	 @param out		phase point at the end of the step
+	 @param error	error estimate of the step
+	 @param Bout	magnetic field at the end of the step
+	 @param h		step in time
+	 @param p		particle state
+	 @param z		redshift
+	 */
+	void tryStep(const Y &y, const Y &k0, Y &out, Y &error, Vector3d &Bout,
+			double h, ParticleState &p, double z) const;
+
+	void setField(ref_ptr<MagneticField> field);
+	void setTolerance(double tolerance);
+	void setMinimumStep(double minStep);
+	void setMaximumStep(double maxStep);
+	/** Event-driven stepping of neutral particles, see propagateNeutral */
+	void setEventDrivenNeutrals(bool eventDriven);
+	bool isEventDrivenNeutrals() const;
+
+	ref_ptr<MagneticField> getField() const;
+	double getTolerance() const;
+	double getMinimumStep() const;
+	double getMaximumStep() const;
+	std::string getDescription() const;
+};
+/** @}*/
+
+} // namespace crpropa
+
+#endif // CRPROPA_PROPAGATIONDP_H
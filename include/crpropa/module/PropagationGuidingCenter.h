@@ -0,0 +1,112 @@
+#ifndef CRPROPA_PROPAGATIONGUIDINGCENTER_H
+#define CRPROPA_PROPAGATIONGUIDINGCENTER_H
+
+#include "crpropa/Module.h"
+#include "crpropa/Units.h"
+#include "crpropa/magneticField/MagneticField.h"
+#include "crpropa/module/PropagationCK.h"
+
+namespace crpropa {
+/**
+ * \addtogroup Propagation
+ * @{
+ */
+
+/**
+ @class PropagationGuidingCenter
+ @brief Propagation of strongly magnetized particles in the guiding center approximation.
+
+ When the gyroradius is small compared to the scale on which the magnetic field changes, the motion of a charged
+ particle splits into the fast gyration and the slow motion of its guiding center: streaming along the field line,
+ the mirror force and the gradient and curvature drifts. This module integrates the guiding center motion with the
+ midpoint method and steps that are a fraction (tolerance) of the field scale length
+ L = min(|B| / |grad |B||, curvature radius), so that it does not need to resolve the gyrations.\n
+ The field derivatives are taken by central differences over the gyroradius, i.e. averaged over the gyro-orbit.
+ The gyroradius for a pitch angle of 90 degrees divided by L is the adiabaticity parameter. If it exceeds the
+ designated maximum, the step is passed on to the full-orbit propagation (PropagationCK by default).\n
+ The candidate keeps the position and direction of the particle. They are converted to the guiding center and the
+ parallel velocity at the beginning of each step and back at the end, where the gyration phase is advanced by the
+ gyrofrequency times the step. The magnetic moment is conserved only approximately by the numerical integration.
+ Neutral particles are passed on to the full-orbit propagation as well. For event-driven stepping of
+ neutral particles (see propagateNeutral) this module has no setting of its own: enable it in the full-orbit
+ propagation, e.g. set a PropagationCK with setEventDrivenNeutrals(true) with setFullOrbitPropagation.
+ */
+class PropagationGuidingCenter: public Module {
+public:
+	/** Field and its derivatives at a point
+	 B			magnetic field
+	 b			unit vector along B (zero for a vanishing field)
+	 gradB		gradient of |B|
+	 curvature	curvature vector of the field lines (b . grad) b
+	 */
+	struct FieldPoint {
+		Vector3d B, b, gradB, curvature;
+		double Bmag;
+	};
+
+private:
+	ref_ptr<MagneticField> field;
+	ref_ptr<Module> fullOrbit;
+	double adiabaticity; /*< maximum ratio of gyroradius and field scale length */
+	double tolerance; /*< step size as fraction of the field scale length */
+	double minStep; /*< minimum step size of the propagation */
+	double maxStep; /*< maximum step size of the propagation */
+
+	Vector3d getFieldAtPosition(const Vector3d &pos, double z) const;
+
+public:
+	/** Constructor
+	 @param field			magnetic field
+	 @param adiabaticity	maximum ratio of gyroradius and field scale length for the guiding center approximation
+	 @param tolerance		step size as fraction of the field scale length
+	 @param minStep			minimum step size
+	 @param maxStep			maximum step size
+	 The full-orbit propagation is a PropagationCK with the same field and step limits.
+	 */
+	PropagationGuidingCenter(ref_ptr<MagneticField> field = NULL,
+			double adiabaticity = 0.01, double tolerance = 0.1,
+			double minStep = (0.1 * kpc), double maxStep = (1 * Gpc));
+	void process(Candidate *candidate) const;
+
+	/** Field and its derivatives at a position
+	 @param pos	position
+	 @param z	redshift
+	 @param d	distance for the central differences
+	 */
+	FieldPoint getFieldPoint(const Vector3d &pos, double z, double d) const;
+
+	/** Field scale length: the smaller of |B| / |grad |B|| and the curvature radius
+	 (infinite for a uniform field)
+	 */
+	double scaleLength(const FieldPoint &f) const;
+
+	/** Time derivative of the guiding center position and the parallel velocity
+	 @param f		field at the guiding center
+	 @param vPar	velocity parallel to the field
+	 @param rigidity	E / (q c), energy over charge times speed of light
+	 @param dXdt	velocity of the guiding center
+	 @param dvdt	change of the parallel velocity (mirror force)
+	 */
+	void derivative(const FieldPoint &f, double vPar, double rigidity,
+			Vector3d &dXdt, double &dvdt) const;
+
+	void setField(ref_ptr<MagneticField> field);
+	void setFullOrbitPropagation(ref_ptr<Module> propagation);
+	void setAdiabaticity(double adiabaticity);
+	void setTolerance(double tolerance);
+	void setMinimumStep(double minStep);
+	void setMaximumStep(double maxStep);
+
+	ref_ptr<MagneticField> getField() const;
+	ref_ptr<Module> getFullOrbitPropagation() const;
+	double getAdiabaticity() const;
+	double getTolerance() const;
+	double getMinimumStep() const;
+	double getMaximumStep() const;
+	std::string getDescription() const;
+};
+/** @}*/
+
+} // namespace crpropa
+
+#endif // CRPROPA_PROPAGATIONGUIDINGCENTER_H
@@ -12,6 +12,10 @@ namespace crpropa {
 /**
  @class Redshift
  @brief Updates redshift and applies adiabatic energy loss according to the traveled distance.
+
+ Small steps use dz = H(z) / c * ds. For steps with dz > 0.001, e.g. of
+ event-driven neutral particles, the redshift is obtained from the comoving
+ distance instead, so that also Gpc steps end at the correct redshift.
  */
 class Redshift: public Module {
 public:
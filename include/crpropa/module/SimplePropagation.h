@@ -17,10 +17,13 @@ namespace crpropa {
  This module implements rectilinear propagation.
  The step size is guaranteed to be larger than minStep and smaller than maxStep.
  It always proposes a next step size of maxStep.
+ In the event-driven mode (setEventDrivenNeutrals) neutral particles are not limited
+ by maxStep and get an unlimited next step.
  */
 class SimplePropagation: public Module {
 private:
 	double minStep, maxStep;
+	bool eventDrivenNeutrals;
 
 public:
 	SimplePropagation(double minStep = (0.1 * kpc), double maxStep = (1 * Gpc));
@@ -29,8 +32,28 @@ public:
 	void setMaximumStep(double maxStep);
 	double getMinimumStep() const;
 	double getMaximumStep() const;
+	/** Event-driven stepping of neutral particles, see propagateNeutral */
+	void setEventDrivenNeutrals(bool eventDriven);
+	bool isEventDrivenNeutrals() const;
 	std::string getDescription() const;
 };
+
+/**
+ Rectilinear step of a neutral particle, as done by the propagation modules
+ (SimplePropagation, PropagationCK, PropagationBP and PropagationDP): the next
+ step of the candidate is clipped to [minStep, maxStep] and maxStep proposed.
+ The previous state has to be saved by the caller.
+
+ In the event-driven mode (setEventDrivenNeutrals of the modules) the step is
+ only limited by minStep and an unlimited next step is proposed, so that it is
+ set by the other modules alone (observers, boundaries, interactions, maximum
+ trajectory length). This requires a module that limits the trajectory. The
+ steps can span Gpc; Redshift then takes the redshift from the comoving
+ distance instead of the small step approximation (FutureRedshift does not).
+ */
+void propagateNeutral(Candidate *candidate, double minStep, double maxStep,
+		bool eventDriven);
+
 /** @}*/
 
 } // namespace crpropa
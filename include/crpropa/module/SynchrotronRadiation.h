@@ -2,6 +2,7 @@
 #define CRPROPA_SYNCHROTRONRADIATION_H
 
 #include "crpropa/Module.h"
+#include "crpropa/AliasTable.h"
 #include "crpropa/magneticField/MagneticField.h"
 
 namespace crpropa {
@@ -21,6 +22,8 @@ namespace crpropa {
  Note that the large number of secondary photons per propagation can cause memory problems.
  To mitigate this, use thinning. However, this still doesn't solve the problem completely.
  For this reason, a break-condition stops tracking secondary photons and reweights the current ones. 
+ Alternatively, the aggregate mode emits a fixed number of weighted photons per step,
+ which together carry exactly the energy loss of the step.
  */
 class SynchrotronRadiation: public Module {
 private:
@@ -33,6 +36,8 @@ private:
 	double secondaryThreshold; ///< threshold energy for secondary photons
 	std::vector<double> tabx; ///< tabulated fraction E_photon/E_critical from 10^-6 to 10^2 in 801 log-spaced steps
 	std::vector<double> tabCDF; ///< tabulated CDF of synchrotron spectrum
+	AliasTable photonBins; ///< alias tables of the bins of tabx, photon number (0) and energy (1) spectrum
+	int aggregatePhotons; ///< number of weighted photons per step in the aggregate mode (0 = off)
 
 
 public:
@@ -45,6 +50,9 @@ public:
 	void setLimit(double limit);
 	void setMaximumSamples(int nmax);
 	void setSecondaryThreshold(double threshold);	
+	/** Emit n weighted photons per step, drawn from the energy spectrum and
+	 weighted such that they carry exactly the energy loss (n = 0 disables the mode) */
+	void setAggregatePhotons(int n);
 	ref_ptr<MagneticField> getField();
 	double getBrms();
 	bool getHavePhotons();
@@ -52,8 +60,21 @@ public:
 	double getLimit();
 	int getMaximumSamples();
 	double getSecondaryThreshold() const;
+	int getAggregatePhotons() const;
 	void initSpectrum();
+	/**
+	 Draw synchrotron photon energies into the buffer until they sum up to the
+	 energy loss, as done in process. The last photon is accepted with
+	 probability dE / E_photon if it exceeds the remaining energy loss.
+	 @param Ecrit		critical energy of the synchrotron spectrum
+	 @param dE			energy loss to distribute
+	 @param energies	buffer for the photon energies, the photons are appended
+	 @param random		random number generator
+	 @returns			the part of the energy loss not carried by the drawn photons
+	 */
+	double drawPhotons(double Ecrit, double dE, std::vector<double> &energies, Random &random) const;
 	void process(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
 	std::string getDescription() const;
 };
 /** @}*/
@@ -0,0 +1,75 @@
+#ifndef CRPROPA_WEIGHTWINDOW_H
+#define CRPROPA_WEIGHTWINDOW_H
+
+#include "crpropa/Module.h"
+#include "crpropa/Geometry.h"
+#include "crpropa/ParticleID.h"
+
+#include <limits>
+#include <vector>
+
+namespace crpropa {
+/**
+ * \addtogroup Tools
+ * @{
+ */
+
+/**
+ @class WeightWindow
+ @brief Population control of the candidates by splitting and Russian roulette
+
+ Each window applies to a set of particle classes, an energy range and
+ optionally a region inside of a closed surface. The first window matching
+ a candidate applies. Candidates with a weight above the window are split
+ into copies with the weight sqrt(lower * upper), see ParticleSplitting::split.
+ Candidates with a weight below the window survive with the probability
+ weight / sqrt(lower * upper) and get that weight, otherwise they are rejected.
+ Both keep the expected total weight.
+
+ In a cascade the number of particles per energy grows roughly as 1 / E.
+ Windows with weights inversely proportional to the energy, e.g. one
+ window per decade, keep the number of candidates roughly constant.
+ */
+class WeightWindow: public AbstractCondition {
+private:
+	struct Window {
+		double lower, upper, survival;
+		unsigned int particleClasses;
+		double minEnergy, maxEnergy;
+		ref_ptr<Surface> region;
+	};
+	std::vector<Window> windows;
+	unsigned int particleClasses;
+	int maximumSplits;
+
+public:
+	/** Constructor
+	 @param maximumSplits	maximum number of candidates a candidate is split into per step
+	 */
+	WeightWindow(int maximumSplits = 10);
+
+	/** Add a window
+	 @param lower			minimum weight, candidates below play Russian roulette
+	 @param upper			maximum weight, candidates above are split
+	 @param particleClasses	bitmask of the ParticleClass values the window applies to
+	 @param minEnergy		minimum energy the window applies to
+	 @param maxEnergy		maximum energy the window applies to
+	 @param region			closed surface, the window applies inside (optional)
+	 */
+	void addWindow(double lower, double upper,
+			unsigned int particleClasses = ParticleClassAll, double minEnergy = 0,
+			double maxEnergy = std::numeric_limits<double>::max(),
+			Surface *region = 0);
+	size_t size() const; ///< number of windows
+	void setMaximumSplits(int maximumSplits);
+	int getMaximumSplits() const;
+
+	void process(Candidate *candidate) const;
+	unsigned int getParticleClasses() const;
+	std::string getDescription() const;
+};
+/** @}*/
+
+} // namespace crpropa
+
+#endif // CRPROPA_WEIGHTWINDOW_H
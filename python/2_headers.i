@@ -140,11 +140,18 @@ using namespace crpropa;   // for usage of namespace in header files, necessary
 %include "crpropa/Units.h"
 %include "crpropa/Common.h"
 %include "crpropa/Cosmology.h"
+%include "crpropa/UniformLogTable.h"
+%include "crpropa/DataTable.h"
+%include "crpropa/TableRegistry.h"
+%ignore crpropa::PhotonFieldSampling::Table;
+%ignore crpropa::PhotonFieldSampling::setTable;
+%ignore crpropa::PhotonFieldSampling::getTable;
 %include "crpropa/PhotonBackground.h"
 %include "crpropa/PhotonPropagation.h"
 %template(RandomSeed) std::vector<uint32_t>;
 %template(RandomSeedThreads) std::vector< std::vector<uint32_t> >;
 %include "crpropa/Random.h"
+%include "crpropa/AliasTable.h"
 %include "crpropa/ParticleState.h"
 %include "crpropa/ParticleID.h"
 %include "crpropa/ParticleMass.h"
@@ -152,8 +159,13 @@ using namespace crpropa;   // for usage of namespace in header files, necessary
 
 %import "crpropa/Variant.h"
 
+%include "crpropa/PropertyKey.h"
+
 /* override Candidate::getProperty() */
 %ignore crpropa::Candidate::getProperty(const std::string &) const;
+%ignore crpropa::Candidate::getProperty(const PropertyKey &) const;
+%ignore crpropa::Candidate::PropertyMap;
+%ignore crpropa::Candidate::properties;
 
 %nothread; /* disable threading for extend*/
 %extend crpropa::Candidate {
@@ -348,6 +360,8 @@ using namespace crpropa;   // for usage of namespace in header files, necessary
 
 %template(CandidateVector) std::vector< crpropa::ref_ptr<crpropa::Candidate> >;
 %template(CandidateRefPtr) crpropa::ref_ptr<crpropa::Candidate>;
+%ignore crpropa::Candidate::operator new;
+%ignore crpropa::Candidate::operator delete;
 %include "crpropa/Candidate.h"
 
 %feature("director") crpropa::Surface;
@@ -358,6 +372,8 @@ using namespace crpropa;   // for usage of namespace in header files, necessary
 %template(stdModuleList) std::list< crpropa::ref_ptr<crpropa::Module> >;
 %feature("director") crpropa::Module;
 %feature("director") crpropa::AbstractCondition;
+%feature("director") crpropa::AbstractInteraction;
+%ignore crpropa::Module::processBatch;
 %include "crpropa/Module.h"
 
 %implicitconv crpropa::ref_ptr<crpropa::MagneticField>;
@@ -429,6 +445,8 @@ using namespace crpropa;   // for usage of namespace in header files, necessary
 %include "crpropa/module/Observer.h"
 %include "crpropa/module/SimplePropagation.h"
 %include "crpropa/module/PropagationCK.h"
+%include "crpropa/module/PropagationDP.h"
+%include "crpropa/module/PropagationGuidingCenter.h"
 %include "crpropa/module/PropagationBP.h"
 
 %ignore crpropa::Output::enableProperty(const std::string &property, const Variant& defaultValue, const std::string &comment = "");
@@ -525,9 +543,11 @@ using namespace crpropa;   // for usage of namespace in header files, necessary
 %include "crpropa/module/EMInverseComptonScattering.h"
 %include "crpropa/module/SynchrotronRadiation.h"
 %include "crpropa/module/AdiabaticCooling.h"
+%include "crpropa/module/CompetingInteractions.h"
 
 %template(IntSet) std::set<int>;
 %include "crpropa/module/Tools.h"
+%include "crpropa/module/WeightWindow.h"
 
 %template(SourceInterfaceRefPtr) crpropa::ref_ptr<crpropa::SourceInterface>;
 %feature("director") crpropa::SourceInterface;
@@ -0,0 +1,86 @@
+#include "crpropa/AliasTable.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace crpropa {
+
+AliasTable::AliasTable() {
+	offsets.push_back(0);
+}
+
+size_t AliasTable::add(const std::vector<double> &cdf) {
+	size_t n = cdf.size();
+	if (n == 0)
+		throw std::runtime_error("AliasTable: empty distribution");
+
+	size_t first = entries.size();
+	entries.resize(first + n);
+	Entry *e = &entries[first];
+	offsets.push_back(first + n);
+
+	double total = cdf.back();
+	if (not (total > 0)) {
+		// Random::randBin always returns the first bin in this case
+		for (size_t k = 0; k < n; k++) {
+			e[k].probability = 0;
+			e[k].alias = 0;
+		}
+		return offsets.size() - 2;
+	}
+
+	// scaled bin probabilities, the average is 1
+	std::vector<double> p(n);
+	for (size_t k = 0; k < n; k++) {
+		double w = cdf[k] - ((k > 0) ? cdf[k - 1] : 0);
+		p[k] = std::max(w, 0.) * n / total;
+	}
+
+	// Vose's method: fill the underfull bins with the overfull ones
+	std::vector<uint32_t> small, large;
+	uint32_t lastLarge = 0;
+	for (size_t k = 0; k < n; k++) {
+		if (p[k] < 1) {
+			small.push_back(k);
+		} else {
+			large.push_back(k);
+			lastLarge = k;
+		}
+	}
+	while (not small.empty() and not large.empty()) {
+		uint32_t s = small.back();
+		small.pop_back();
+		uint32_t l = large.back();
+		lastLarge = l;
+		e[s].probability = p[s];
+		e[s].alias = l;
+		p[l] -= 1 - p[s];
+		if (p[l] < 1) {
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+	// the remaining bins are full up to rounding errors
+	for (size_t i = 0; i < large.size(); i++) {
+		e[large[i]].probability = 1;
+		e[large[i]].alias = large[i];
+	}
+	for (size_t i = 0; i < small.size(); i++) {
+		uint32_t s = small[i];
+		// a bin without weight must never be drawn
+		e[s].probability = (p[s] > 0) ? 1 : 0;
+		e[s].alias = lastLarge;
+	}
+
+	return offsets.size() - 2;
+}
+
+size_t AliasTable::size() const {
+	return offsets.size() - 1;
+}
+
+size_t AliasTable::bins(size_t distribution) const {
+	return offsets[distribution + 1] - offsets[distribution];
+}
+
+} // namespace crpropa
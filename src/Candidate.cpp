@@ -1,13 +1,39 @@
 #include "crpropa/Candidate.h"
 #include "crpropa/ParticleID.h"
+#include "crpropa/Random.h"
 #include "crpropa/Units.h"
 
 #include <stdexcept>
+#include <new>
 
 namespace crpropa {
 
+/**
+ Per-thread pool of recycled candidate memory and secondary storage.
+ Memory blocks may be returned to the pool of another thread than the one
+ that allocated them, as all blocks have the size of a Candidate.
+ */
+struct CandidatePool {
+	std::vector<void*> blocks;
+	std::vector<std::vector<ref_ptr<Candidate> > > buffers;
+
+	~CandidatePool();
+};
+
+// trivially destructible, so that it can be checked after the pool is gone
+static thread_local bool candidatePoolDestroyed = false;
+static thread_local CandidatePool candidatePool;
+
+CandidatePool::~CandidatePool() {
+	candidatePoolDestroyed = true;
+	for (size_t i = 0; i < blocks.size(); i++)
+		::operator delete(blocks[i]);
+	blocks.clear();
+	buffers.clear();
+}
+
 Candidate::Candidate(int id, double E, Vector3d pos, Vector3d dir, double z, double weight) :
-		redshift(z), trajectoryLength(0), weight(1), currentStep(0), nextStep(0), active(true), parent(0) {
+		redshift(z), trajectoryLength(0), weight(1), currentStep(0), nextStep(0), active(true), parent(0), randomStream(0), randomCounter(0), secondaryCounter(0) {
 	ParticleState state(id, E, pos, dir);
 	source = state;
 	created = state;
@@ -27,7 +53,7 @@ Candidate::Candidate(int id, double E, Vector3d pos, Vector3d dir, double z, dou
 }
 
 Candidate::Candidate(const ParticleState &state) :
-		source(state), created(state), current(state), previous(state), redshift(0), trajectoryLength(0), currentStep(0), nextStep(0), active(true), parent(0) {
+		source(state), created(state), current(state), previous(state), redshift(0), trajectoryLength(0), currentStep(0), nextStep(0), active(true), parent(0), randomStream(0), randomCounter(0), secondaryCounter(0) {
 
 #if defined(OPENMP_3_1)
 		#pragma omp atomic capture
@@ -41,6 +67,22 @@ Candidate::Candidate(const ParticleState &state) :
 
 }
 
+Candidate::~Candidate() {
+	if (!poolAllocation || (secondaries.capacity() == 0) || candidatePoolDestroyed)
+		return;
+	// large buffers are freed, so that the pool does not hold on to the memory of a large cascade
+	if (secondaries.capacity() > maximumBufferCapacity)
+		return;
+
+	// releasing the secondaries may return their storage to the pool as well
+	secondaries.clear();
+	std::vector<std::vector<ref_ptr<Candidate> > > &buffers = candidatePool.buffers;
+	if (buffers.size() < maximumPoolSize) {
+		buffers.push_back(std::vector<ref_ptr<Candidate> >());
+		buffers.back().swap(secondaries);
+	}
+}
+
 bool Candidate::isActive() const {
 	return active;
 }
@@ -94,33 +136,100 @@ void Candidate::limitNextStep(double step) {
 	nextStep = std::min(nextStep, step);
 }
 
+Variant &Candidate::PropertyMap::operator[](const PropertyKey &key) {
+	iterator i = find(key);
+	if (i != end())
+		return i->second;
+
+	if (!onHeap && (count == nInlineSlots)) {
+		heapSlots.reserve(2 * nInlineSlots);
+		for (size_t j = 0; j < count; j++) {
+			heapSlots.push_back(inlineSlots[j]);
+			inlineSlots[j] = value_type();
+		}
+		onHeap = true;
+	}
+
+	if (onHeap) {
+		heapSlots.push_back(value_type(key, Variant()));
+		count++;
+		return heapSlots.back().second;
+	}
+
+	inlineSlots[count].first = key;
+	return inlineSlots[count++].second;
+}
+
+void Candidate::PropertyMap::erase(iterator i) {
+	if (onHeap) {
+		heapSlots.erase(heapSlots.begin() + (i - begin()));
+	} else {
+		for (iterator j = i + 1; j != end(); ++j)
+			*(j - 1) = *j;
+		inlineSlots[count - 1] = value_type();
+	}
+	count--;
+}
+
+void Candidate::PropertyMap::clear() {
+	for (size_t j = 0; j < nInlineSlots; j++)
+		inlineSlots[j] = value_type();
+	heapSlots.clear();
+	count = 0;
+	onHeap = false;
+}
+
 void Candidate::setProperty(const std::string &name, const Variant &value) {
-	properties[name] = value;
+	setProperty(PropertyKey(name), value);
 }
 
 const Variant &Candidate::getProperty(const std::string &name) const {
-	PropertyMap::const_iterator i = properties.find(name);
+	return getProperty(PropertyKey(name));
+}
+
+bool Candidate::removeProperty(const std::string& name) {
+	return removeProperty(PropertyKey(name));
+}
+
+bool Candidate::hasProperty(const std::string &name) const {
+	return hasProperty(PropertyKey(name));
+}
+
+void Candidate::setProperty(const PropertyKey &key, const Variant &value) {
+	properties[key] = value;
+}
+
+const Variant &Candidate::getProperty(const PropertyKey &key) const {
+	PropertyMap::const_iterator i = properties.find(key);
 	if (i == properties.end())
-		throw std::runtime_error("Unknown candidate property: " + name);
+		throw std::runtime_error("Unknown candidate property: " + key.getName());
 	return i->second;
 }
 
-bool Candidate::removeProperty(const std::string& name) {
-	PropertyMap::iterator i = properties.find(name);
+bool Candidate::removeProperty(const PropertyKey &key) {
+	PropertyMap::iterator i = properties.find(key);
 	if (i == properties.end())
 		return false;
 	properties.erase(i);
 	return true;
 }
 
-bool Candidate::hasProperty(const std::string &name) const {
-	PropertyMap::const_iterator i = properties.find(name);
+bool Candidate::hasProperty(const PropertyKey &key) const {
+	PropertyMap::const_iterator i = properties.find(key);
 	if (i == properties.end())
 		return false;
 	return true;
 }
 
 void Candidate::addSecondary(Candidate *c) {
+	if ((secondaries.capacity() == 0) && poolAllocation && !candidatePoolDestroyed) {
+		std::vector<std::vector<ref_ptr<Candidate> > > &buffers = candidatePool.buffers;
+		if (!buffers.empty()) {
+			secondaries.swap(buffers.back());
+			buffers.pop_back();
+		}
+	}
+	c->setRandomStream(Random::deriveStream(randomStream, secondaryCounter++));
 	secondaries.push_back(c);
 }
 
@@ -136,7 +245,7 @@ void Candidate::addSecondary(int id, double energy, double weight) {
 	secondary->current.setId(id);
 	secondary->current.setEnergy(energy);
 	secondary->parent = this;
-	secondaries.push_back(secondary);
+	addSecondary(secondary);
 }
 
 void Candidate::addSecondary(int id, double energy, Vector3d position, double weight) {
@@ -153,7 +262,7 @@ void Candidate::addSecondary(int id, double energy, Vector3d position, double we
 	secondary->current.setPosition(position);
 	secondary->created.setPosition(position);
 	secondary->parent = this;
-	secondaries.push_back(secondary);
+	addSecondary(secondary);
 }
 
 void Candidate::clearSecondaries() {
@@ -182,6 +291,9 @@ ref_ptr<Candidate> Candidate::clone(bool recursive) const {
 	cloned->trajectoryLength = trajectoryLength;
 	cloned->currentStep = currentStep;
 	cloned->nextStep = nextStep;
+	cloned->randomStream = randomStream;
+	cloned->randomCounter = randomCounter;
+	cloned->secondaryCounter = secondaryCounter;
 	if (recursive) {
 		cloned->secondaries.reserve(secondaries.size());
 		for (size_t i = 0; i < secondaries.size(); i++) {
@@ -215,6 +327,24 @@ uint64_t Candidate::getCreatedSerialNumber() const {
 		return serialNumber;
 }
 
+void Candidate::setRandomStream(uint64_t stream, uint64_t counter) {
+	randomStream = stream;
+	randomCounter = counter;
+	secondaryCounter = 0;
+}
+
+uint64_t Candidate::getRandomStream() const {
+	return randomStream;
+}
+
+uint64_t Candidate::getRandomCounter() const {
+	return randomCounter;
+}
+
+void Candidate::setRandomCounter(uint64_t counter) {
+	randomCounter = counter;
+}
+
 void Candidate::setNextSerialNumber(uint64_t snr) {
 	nextSerialNumber = snr;
 }
@@ -232,4 +362,58 @@ void Candidate::restart() {
 	current = source;
 }
 
+bool Candidate::poolAllocation = true;
+size_t Candidate::maximumPoolSize = 16384;
+size_t Candidate::maximumBufferCapacity = 1024;
+
+void Candidate::setPoolAllocation(bool enable) {
+	poolAllocation = enable;
+}
+
+bool Candidate::getPoolAllocation() {
+	return poolAllocation;
+}
+
+void Candidate::setMaximumPoolSize(size_t size) {
+	maximumPoolSize = size;
+}
+
+size_t Candidate::getMaximumPoolSize() {
+	return maximumPoolSize;
+}
+
+void Candidate::setMaximumBufferCapacity(size_t capacity) {
+	maximumBufferCapacity = capacity;
+}
+
+size_t Candidate::getMaximumBufferCapacity() {
+	return maximumBufferCapacity;
+}
+
+void *Candidate::operator new(size_t size) {
+	// derived classes have a different size and are not pooled
+	if (poolAllocation && (size == sizeof(Candidate)) && !candidatePoolDestroyed) {
+		std::vector<void*> &blocks = candidatePool.blocks;
+		if (!blocks.empty()) {
+			void *ptr = blocks.back();
+			blocks.pop_back();
+			return ptr;
+		}
+	}
+	return ::operator new(size);
+}
+
+void Candidate::operator delete(void *ptr, size_t size) {
+	if (ptr == 0)
+		return;
+	if (poolAllocation && (size == sizeof(Candidate)) && !candidatePoolDestroyed) {
+		std::vector<void*> &blocks = candidatePool.blocks;
+		if (blocks.size() < maximumPoolSize) {
+			blocks.push_back(ptr);
+			return;
+		}
+	}
+	::operator delete(ptr);
+}
+
 } // namespace crpropa
@@ -1,6 +1,7 @@
 #include "crpropa/Cosmology.h"
 #include "crpropa/Units.h"
 #include "crpropa/Common.h"
+#include "crpropa/UniformLogTable.h"
 
 #include <vector>
 #include <cmath>
@@ -26,6 +27,11 @@ struct Cosmology {
 	std::vector<double> Dl; // luminosity distance [m]
 	std::vector<double> Dt; // light travel distance [m]
 
+	// distances as function of the redshift with O(1) lookup
+	UniformLogTable DcOfZ;
+	UniformLogTable DlOfZ;
+	UniformLogTable DtOfZ;
+
 	void update() {
 		double dH = c_light / H0; // Hubble distance
 
@@ -46,6 +52,10 @@ struct Cosmology {
 							* (1 / ((1 + Z[i]) * E[i])
 									+ 1 / ((1 + Z[i - 1]) * E[i - 1])) / 2;
 		}
+
+		DcOfZ = UniformLogTable(Z, Dc);
+		DlOfZ = UniformLogTable(Z, Dl);
+		DtOfZ = UniformLogTable(Z, Dt);
 	}
 
 	Cosmology() {
@@ -115,7 +125,7 @@ double redshift2ComovingDistance(double z) {
 		throw std::runtime_error("Cosmology: z < 0");
 	if (z > cosmology.zmax)
 		throw std::runtime_error("Cosmology: z > zmax");
-	return interpolate(z, cosmology.Z, cosmology.Dc);
+	return cosmology.DcOfZ.interpolate(z);
 }
 
 double luminosityDistance2Redshift(double d) {
@@ -131,7 +141,7 @@ double redshift2LuminosityDistance(double z) {
 		throw std::runtime_error("Cosmology: z < 0");
 	if (z > cosmology.zmax)
 		throw std::runtime_error("Cosmology: z > zmax");
-	return interpolate(z, cosmology.Z, cosmology.Dl);
+	return cosmology.DlOfZ.interpolate(z);
 }
 
 double lightTravelDistance2Redshift(double d) {
@@ -147,7 +157,7 @@ double redshift2LightTravelDistance(double z) {
 		throw std::runtime_error("Cosmology: z < 0");
 	if (z > cosmology.zmax)
 		throw std::runtime_error("Cosmology: z > zmax");
-	return interpolate(z, cosmology.Z, cosmology.Dt);
+	return cosmology.DtOfZ.interpolate(z);
 }
 
 double comoving2LightTravelDistance(double d) {
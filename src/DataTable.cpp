@@ -0,0 +1,278 @@
+#include "crpropa/DataTable.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#if defined(WIN32) || defined(_WIN32)
+#define CRPROPA_NO_MMAP
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace crpropa {
+
+namespace {
+
+const char cacheMagic[8] = {'C', 'R', 'P', 'T', 'A', 'B', 'L', 'E'};
+const uint32_t cacheByteOrder = 0x01020304;
+
+// followed by (nRows + 1) uint64_t row offsets and nValues doubles
+struct CacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint64_t nRows;
+	uint64_t nValues;
+	int64_t sourceSize;
+	int64_t sourceTime;
+};
+
+// size and modification time of a file, false if it does not exist
+bool fileStatus(const std::string &filename, int64_t &size, int64_t &time) {
+	struct stat s;
+	if (stat(filename.c_str(), &s) != 0)
+		return false;
+	size = s.st_size;
+	time = s.st_mtime;
+	return true;
+}
+
+bool validHeader(const CacheHeader &header, size_t fileSize) {
+	if (std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0)
+		return false;
+	if (header.version != DataTable::formatVersion)
+		return false;
+	if (header.byteOrder != cacheByteOrder)
+		return false;
+	uint64_t expected = sizeof(CacheHeader)
+			+ (header.nRows + 1) * sizeof(uint64_t)
+			+ header.nValues * sizeof(double);
+	return expected == fileSize;
+}
+
+bool matchesSource(const CacheHeader &header, const std::string &filename) {
+	int64_t size, time;
+	if (!fileStatus(filename, size, time))
+		return true; // only the cache is installed
+	return (header.sourceSize == size) and (header.sourceTime == time);
+}
+
+} // namespace
+
+bool DataTable::useCache = true;
+
+DataTable::DataTable() :
+		mapping(0), mappingSize(0), valuePtr(0), offsetPtr(0), nRows(0) {
+}
+
+DataTable::DataTable(const std::string &filename) :
+		mapping(0), mappingSize(0), valuePtr(0), offsetPtr(0), nRows(0) {
+	load(filename);
+}
+
+DataTable::~DataTable() {
+	clear();
+}
+
+bool DataTable::load(const std::string &filename) {
+	clear();
+	if (useCache and loadCache(filename))
+		return true;
+	return loadText(filename);
+}
+
+bool DataTable::good() const {
+	return offsetPtr != 0;
+}
+
+bool DataTable::isMapped() const {
+	return mapping != 0;
+}
+
+size_t DataTable::rows() const {
+	return nRows;
+}
+
+size_t DataTable::columns(size_t i) const {
+	return offsetPtr[i + 1] - offsetPtr[i];
+}
+
+const double *DataTable::row(size_t i) const {
+	return valuePtr + offsetPtr[i];
+}
+
+double DataTable::get(size_t i, size_t j) const {
+	return valuePtr[offsetPtr[i] + j];
+}
+
+size_t DataTable::size() const {
+	return good() ? offsetPtr[nRows] : 0;
+}
+
+const double *DataTable::data() const {
+	return valuePtr;
+}
+
+std::string DataTable::cacheName(const std::string &filename) {
+	return filename + ".bin";
+}
+
+void DataTable::setUseCache(bool use) {
+	useCache = use;
+}
+
+bool DataTable::getUseCache() {
+	return useCache;
+}
+
+void DataTable::clear() {
+#ifndef CRPROPA_NO_MMAP
+	if (mapping)
+		munmap(mapping, mappingSize);
+#endif
+	mapping = 0;
+	mappingSize = 0;
+	values.clear();
+	offsets.clear();
+	valuePtr = 0;
+	offsetPtr = 0;
+	nRows = 0;
+}
+
+bool DataTable::loadCache(const std::string &filename) {
+	std::string cachename = cacheName(filename);
+#ifdef CRPROPA_NO_MMAP
+	std::ifstream infile(cachename.c_str(), std::ios::binary);
+	if (!infile.good())
+		return false;
+	CacheHeader header;
+	infile.read((char*) &header, sizeof(header));
+	infile.seekg(0, std::ios::end);
+	size_t fileSize = infile.tellg();
+	if (!infile or !validHeader(header, fileSize) or !matchesSource(header, filename))
+		return false;
+	offsets.resize(header.nRows + 1);
+	values.resize(header.nValues);
+	infile.seekg(sizeof(header));
+	infile.read((char*) &offsets[0], offsets.size() * sizeof(uint64_t));
+	if (header.nValues > 0)
+		infile.read((char*) &values[0], values.size() * sizeof(double));
+	if (!infile) {
+		clear();
+		return false;
+	}
+	nRows = header.nRows;
+	offsetPtr = &offsets[0];
+	valuePtr = values.empty() ? 0 : &values[0];
+	return true;
+#else
+	int fd = open(cachename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat s;
+	if ((fstat(fd, &s) != 0) or (s.st_size < (off_t) sizeof(CacheHeader))) {
+		close(fd);
+		return false;
+	}
+	void *p = mmap(0, s.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); // the mapping stays valid
+	if (p == MAP_FAILED)
+		return false;
+
+	const CacheHeader &header = *(const CacheHeader*) p;
+	if (!validHeader(header, s.st_size) or !matchesSource(header, filename)) {
+		munmap(p, s.st_size);
+		return false;
+	}
+	mapping = p;
+	mappingSize = s.st_size;
+	nRows = header.nRows;
+	offsetPtr = (const uint64_t*) ((const char*) p + sizeof(CacheHeader));
+	valuePtr = (const double*) (offsetPtr + nRows + 1);
+	return true;
+#endif
+}
+
+bool DataTable::loadText(const std::string &filename) {
+	std::ifstream infile(filename.c_str());
+	if (!infile.good())
+		return false;
+
+	offsets.push_back(0);
+	std::string line;
+	size_t lineNumber = 0;
+	while (std::getline(infile, line)) {
+		lineNumber++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+
+		const char *p = line.c_str();
+		size_t n = values.size();
+		while (true) {
+			while ((*p == ' ') or (*p == '\t') or (*p == '\r'))
+				p++;
+			if (*p == '\0')
+				break;
+			char *end;
+			double value = std::strtod(p, &end);
+			if (end == p) {
+				std::stringstream ss;
+				ss << "crpropa::DataTable: could not parse line " << lineNumber
+						<< " of " << filename;
+				throw std::runtime_error(ss.str());
+			}
+			values.push_back(value);
+			p = end;
+		}
+		if (values.size() > n)
+			offsets.push_back(values.size());
+	}
+
+	nRows = offsets.size() - 1;
+	offsetPtr = &offsets[0];
+	valuePtr = values.empty() ? 0 : &values[0];
+	return true;
+}
+
+void DataTable::convert(const std::string &filename, std::string cachename) {
+	if (cachename.empty())
+		cachename = cacheName(filename);
+
+	DataTable table;
+	if (!table.loadText(filename))
+		throw std::runtime_error("crpropa::DataTable: could not open file " + filename);
+
+	CacheHeader header;
+	std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+	header.version = formatVersion;
+	header.byteOrder = cacheByteOrder;
+	header.nRows = table.rows();
+	header.nValues = table.size();
+	fileStatus(filename, header.sourceSize, header.sourceTime);
+
+	// write to a temporary file and rename, so that running processes
+	// never map a partially written cache
+	std::string tmpname = cachename + ".tmp";
+	std::ofstream outfile(tmpname.c_str(), std::ios::binary);
+	if (!outfile.good())
+		throw std::runtime_error("crpropa::DataTable: could not open file " + tmpname);
+	outfile.write((const char*) &header, sizeof(header));
+	outfile.write((const char*) &table.offsets[0], table.offsets.size() * sizeof(uint64_t));
+	if (!table.values.empty())
+		outfile.write((const char*) &table.values[0], table.values.size() * sizeof(double));
+	outfile.close();
+	if (!outfile or (std::rename(tmpname.c_str(), cachename.c_str()) != 0)) {
+		std::remove(tmpname.c_str());
+		throw std::runtime_error("crpropa::DataTable: could not write file " + cachename);
+	}
+}
+
+} // namespace crpropa
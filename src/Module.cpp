@@ -17,6 +17,15 @@ void Module::setDescription(const std::string &d) {
 	description = d;
 }
 
+void Module::processBatch(Candidate **candidates, size_t n) const {
+	for (size_t i = 0; i < n; i++)
+		process(candidates[i]);
+}
+
+unsigned int Module::getParticleClasses() const {
+	return ParticleClassAll;
+}
+
 AbstractCondition::AbstractCondition() :
 		makeRejectedInactive(true), makeAcceptedInactive(false), rejectFlagKey(
 				"Rejected") {
@@ -40,6 +40,26 @@ bool isNucleus(int id) {
 	return HepPID::isNucleus(id);
 }
 
+unsigned int particleClass(int id) {
+	switch (id) {
+	case 22:
+		return ParticleClassPhoton;
+	case 11:
+	case -11:
+		return ParticleClassElectron;
+	case 12:
+	case -12:
+	case 14:
+	case -14:
+	case 16:
+	case -16:
+		return ParticleClassNeutrino;
+	}
+	if (isNucleus(id))
+		return ParticleClassNucleus;
+	return ParticleClassOther;
+}
+
 std::string convertIdToName(int id) {
 	// handle a few extra cases that HepPID doesn't like
 	if (id == 1000000010) // neutron
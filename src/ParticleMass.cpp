@@ -1,13 +1,13 @@
 #include "crpropa/ParticleMass.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/Common.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/Units.h"
 
 #include "kiss/convert.h"
 #include "kiss/logger.h"
 
 #include <vector>
-#include <fstream>
 #include <stdexcept>
 #include <limits>
 
@@ -23,22 +23,17 @@ struct NuclearMassTable {
 
 	void init() {
 		std::string filename = getDataPath("nuclear_mass.txt");
-		std::ifstream infile(filename.c_str());
+		DataTable data(filename);
 
-		if (!infile.good())
+		if (!data.good())
 			throw std::runtime_error("crpropa: could not open file " + filename);
 
-		int Z, N;
-		double mass;
-		while (infile.good()) {
-			if (infile.peek() != '#') {
-				infile >> Z >> N >> mass;
-				table.push_back(mass);
-			}
-			infile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+		// rows: Z, N, mass
+		for (size_t i = 0; i < data.rows(); i++) {
+			if (data.columns(i) >= 3)
+				table.push_back(data.get(i, 2));
 		}
 
-		infile.close();
 		initialized = true;
 	}
 
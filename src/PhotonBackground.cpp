@@ -5,6 +5,7 @@
 #include <fstream>
 #include <stdexcept>
 #include <limits>
+#include <algorithm>
 #include <cmath>
 
 namespace crpropa {
@@ -20,15 +21,20 @@ TabularPhotonField::TabularPhotonField(std::string fieldName, bool isRedshiftDep
 
 	checkInputData();
 
-	if (this->isRedshiftDependent)
+	if (this->isRedshiftDependent) {
+		this->densityTable2D = UniformLogTable2D(this->photonEnergies, this->redshifts, this->photonDensity);
 		initRedshiftScaling();
+		this->scalingTable = UniformLogTable(this->redshifts, this->redshiftScalings);
+	} else {
+		this->densityTable = UniformLogTable(this->photonEnergies, this->photonDensity);
+	}
 }
 
 double TabularPhotonField::getPhotonDensity(double ePhoton, double z) const {
 	if (this->isRedshiftDependent) {
-		return interpolate2d(ePhoton, z, this->photonEnergies, this->redshifts, this->photonDensity);
+		return this->densityTable2D.interpolate(ePhoton, z);
 	} else {
-		return interpolate(ePhoton, this->photonEnergies, this->photonDensity);
+		return this->densityTable.interpolate(ePhoton);
 	}
 }
 
@@ -39,7 +45,7 @@ double TabularPhotonField::getRedshiftScaling(double z) const {
 		} else if (z < this->redshifts.front()) {
 			return 1.;
 		} else {
-			return interpolate(z, this->redshifts, this->redshiftScalings);
+			return this->scalingTable.interpolate(z);
 		}
 	} else {
 		return 1.;
@@ -169,6 +175,12 @@ double PhotonFieldSampling::sample_eps(bool onProton, double E_in, double z_in)
 	if (bgFlag == 0)
 		throw std::runtime_error("error: select photon field first: 1 (CMB) or 2 (IRB_Kneiske04)");
 
+	if (table) {
+		double eps = sampleTable(onProton, E_in, z_in);
+		if (eps > 0)
+			return eps * eV;
+	}
+
 	const double mass = onProton? 0.93827 : 0.93947;  // Gev/c^2
 	const double P_in = sqrt(E_in * E_in - mass * mass);  // GeV/c
 
@@ -238,6 +250,131 @@ double PhotonFieldSampling::sample_eps(bool onProton, double E_in, double z_in)
 	return eps * eV;
 }
 
+void PhotonFieldSampling::initTable(double lgEmin, double lgEmax, int binsPerDecade,
+		double zMax, int nRedshifts, int nQuantiles) {
+	if (bgFlag == 0)
+		throw std::runtime_error("error: select photon field first: 1 (CMB) or 2 (IRB_Kneiske04)");
+	if ((lgEmax <= lgEmin) or (binsPerDecade < 1) or (zMax <= 0) or (nRedshifts < 2) or (nQuantiles < 2))
+		throw std::runtime_error("PhotonFieldSampling: invalid table range");
+
+	ref_ptr<Table> t = new Table();
+	t->nE = static_cast<size_t>(std::ceil((lgEmax - lgEmin) * binsPerDecade)) + 1;
+	t->lgEmin = lgEmin;
+	t->dlgE = 1. / binsPerDecade;
+	t->nz = nRedshifts;
+	t->dz = zMax / (nRedshifts - 1);
+	t->nQuantiles = nQuantiles;
+	size_t nCells = 2 * t->nE * t->nz;
+	t->valid.assign(nCells, 0);
+	t->lnEps.assign(nCells * t->nQuantiles, 0.);
+
+	// cumulative distribution in ln(eps), tabulated at nPoints points
+	const int nPoints = 100;
+
+#pragma omp parallel for schedule(dynamic)
+	for (int cell = 0; cell < static_cast<int>(nCells); cell++) {
+		bool onProton = (cell / (t->nE * t->nz) == 0);
+		double E_in = std::pow(10., t->lgEmin + (cell / t->nz % t->nE) * t->dlgE);
+		double z_in = (cell % t->nz) * t->dz;
+
+		double epsMin, epsMax;
+		if (not epsRange(onProton, E_in, z_in, epsMin, epsMax))
+			continue;
+
+		double dlnEps = std::log(epsMax / epsMin) / (nPoints - 1);
+		std::vector<double> lnEps(nPoints), cdf(nPoints);
+		double pdfLast = 0;
+		for (int i = 0; i < nPoints; i++) {
+			lnEps[i] = std::log(epsMin) + i * dlnEps;
+			double eps = std::exp(lnEps[i]);
+			double pdf = epsDistribution(eps, onProton, E_in, z_in) * eps;
+			cdf[i] = (i > 0) ? cdf[i - 1] + (pdf + pdfLast) / 2 * dlnEps : 0;
+			pdfLast = pdf;
+		}
+		if (not (cdf.back() > 0))
+			continue;
+
+		// invert the cumulative distribution at the quantiles u = (1 - cos(pi t)) / 2
+		// for equidistant t, which resolves the tails of the distribution
+		double *q = &t->lnEps[cell * t->nQuantiles];
+		int i = 1;
+		for (size_t k = 0; k < t->nQuantiles; k++) {
+			double u = cdf.back() * (1 - std::cos(M_PI * k / (t->nQuantiles - 1))) / 2;
+			while ((i < nPoints - 1) and (cdf[i] < u))
+				i++;
+			double dcdf = cdf[i] - cdf[i - 1];
+			double f = (dcdf > 0) ? std::min(std::max((u - cdf[i - 1]) / dcdf, 0.), 1.) : 0;
+			q[k] = lnEps[i - 1] + f * dlnEps;
+		}
+		t->valid[cell] = 1;
+	}
+	table = t;
+}
+
+bool PhotonFieldSampling::hasTable() const {
+	return table.valid();
+}
+
+void PhotonFieldSampling::setTable(ref_ptr<Table> t) {
+	table = t;
+}
+
+ref_ptr<PhotonFieldSampling::Table> PhotonFieldSampling::getTable() const {
+	return table;
+}
+
+double PhotonFieldSampling::sampleTable(bool onProton, double E_in, double z_in) const {
+	const Table &t = *table;
+	double x = (std::log10(E_in) - t.lgEmin) / t.dlgE;
+	double y = z_in / t.dz;
+	if ((x < 0) or (x > t.nE - 1) or (y < 0) or (y > t.nz - 1))
+		return 0;
+	size_t iE = std::min(static_cast<size_t>(x), t.nE - 2);
+	size_t iz = std::min(static_cast<size_t>(y), t.nz - 2);
+	double fE = x - iE;
+	double fz = y - iz;
+
+	// the four neighbouring cells must be above threshold
+	size_t cell = ((onProton ? 0 : 1) * t.nE + iE) * t.nz + iz;
+	if (not (t.valid[cell] and t.valid[cell + 1] and t.valid[cell + t.nz] and t.valid[cell + t.nz + 1]))
+		return 0;
+
+	// same quantile in all cells, interpolated bilinearly in (log10(E_in), z_in)
+	double u = std::acos(1 - 2 * Random::instance().rand()) / M_PI * (t.nQuantiles - 1);
+	size_t k = std::min(static_cast<size_t>(u), t.nQuantiles - 2);
+	double f = u - k;
+	const double *q = &t.lnEps[cell * t.nQuantiles + k];
+	const size_t dz = t.nQuantiles;
+	const size_t dE = t.nz * t.nQuantiles;
+	double q00 = q[0] + f * (q[1] - q[0]);
+	double q01 = q[dz] + f * (q[dz + 1] - q[dz]);
+	double q10 = q[dE] + f * (q[dE + 1] - q[dE]);
+	double q11 = q[dE + dz] + f * (q[dE + dz + 1] - q[dE + dz]);
+	double lnEps = (1 - fE) * ((1 - fz) * q00 + fz * q01) + fE * ((1 - fz) * q10 + fz * q11);
+	return std::exp(lnEps);
+}
+
+bool PhotonFieldSampling::epsRange(bool onProton, double E_in, double z_in, double &epsMin, double &epsMax) const {
+	const double mass = onProton? 0.93827 : 0.93947;  // Gev/c^2
+	const double P_in = sqrt(E_in * E_in - mass * mass);  // GeV/c
+	const double epsThreshold = (1.1646 - mass * mass) / 2. / (E_in + P_in) * 1.e9;  // eV
+	if (bgFlag == 1) {
+		epsMin = epsThreshold;
+		epsMax = 0.007 * 2.73 * (1. + z_in);
+	} else {
+		epsMin = std::max(0.00395, epsThreshold);
+		epsMax = 12.2;
+	}
+	return epsMin < epsMax;
+}
+
+double PhotonFieldSampling::epsDistribution(double eps, bool onProton, double E_in, double z_in) const {
+	if (bgFlag == 1)
+		return prob_eps(eps, onProton, E_in, z_in);
+	// the rejection sampling of the IRB draws from eps^-4 and accepts with eps^2 * n(eps)
+	return getPhotonDensity(eps, z_in) / (eps * eps);
+}
+
 double PhotonFieldSampling::prob_eps(double eps, bool onProton, double E_in, double z_in) const {
 	const double mass = onProton? 0.93827 : 0.93947;  // Gev/c^2
 	double gamma = E_in / mass;
@@ -0,0 +1,73 @@
+#include "crpropa/PropertyKey.h"
+
+#include <deque>
+#include <map>
+#include <unordered_map>
+
+namespace crpropa {
+
+struct PropertyKeyRegistry {
+	std::map<std::string, uint32_t> ids;
+	std::deque<std::string> names; // references stay valid on push_back
+
+	PropertyKeyRegistry() {
+		ids[""] = 0;
+		names.push_back("");
+	}
+};
+
+static PropertyKeyRegistry &propertyKeyRegistry() {
+	static PropertyKeyRegistry registry;
+	return registry;
+}
+
+uint32_t PropertyKey::intern(const std::string &name) {
+	// each thread keeps a copy of the handles it has seen, so that the
+	// lookup of a known name does not need the lock on the registry
+	static thread_local std::unordered_map<std::string, uint32_t> cache;
+	std::unordered_map<std::string, uint32_t>::const_iterator i = cache.find(name);
+	if (i != cache.end())
+		return i->second;
+
+	uint32_t id;
+#pragma omp critical(PropertyKeyRegistry)
+	{
+		PropertyKeyRegistry &registry = propertyKeyRegistry();
+		std::map<std::string, uint32_t>::const_iterator j = registry.ids.find(name);
+		if (j == registry.ids.end()) {
+			id = registry.names.size();
+			registry.ids[name] = id;
+			registry.names.push_back(name);
+		} else {
+			id = j->second;
+		}
+	}
+	cache[name] = id;
+	return id;
+}
+
+PropertyKey::PropertyKey() : id(0) {
+}
+
+PropertyKey::PropertyKey(const std::string &name) : id(intern(name)) {
+}
+
+const std::string &PropertyKey::getName() const {
+	const std::string *name;
+#pragma omp critical(PropertyKeyRegistry)
+	name = &propertyKeyRegistry().names[id];
+	return *name;
+}
+
+size_t PropertyKey::getRegistrySize() {
+	size_t size;
+#pragma omp critical(PropertyKeyRegistry)
+	size = propertyKeyRegistry().names.size();
+	return size;
+}
+
+std::ostream &operator<<(std::ostream &out, const PropertyKey &key) {
+	return out << key.getName();
+}
+
+} // namespace crpropa
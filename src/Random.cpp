@@ -65,15 +65,15 @@
 
 namespace crpropa {
 
-Random::Random(const uint32_t& oneSeed) {
+Random::Random(const uint32_t& oneSeed) : counterBased(false), stream(0), counter(0) {
 	seed(oneSeed);
 }
 
-Random::Random(uint32_t * const bigSeed, const uint32_t seedLength) {
+Random::Random(uint32_t * const bigSeed, const uint32_t seedLength) : counterBased(false), stream(0), counter(0) {
 	seed(bigSeed, seedLength);
 }
 
-Random::Random() {
+Random::Random() : counterBased(false), stream(0), counter(0) {
 	seed();
 }
 
@@ -114,6 +114,22 @@ double Random::randNorm(const double& mean, const double& variance) {
 	return mean + r * cos(phi);
 }
 
+void Random::randNormArray(double *values, size_t n) {
+	// draw the uniform numbers first, then transform them in a separate loop
+	for (size_t i = 0; i + 1 < n; i += 2) {
+		values[i] = randDblExc();
+		values[i + 1] = randExc();
+	}
+	for (size_t i = 0; i + 1 < n; i += 2) {
+		double r = sqrt(-2.0 * log(1.0 - values[i]));
+		double phi = 2.0 * 3.14159265358979323846264338328 * values[i + 1];
+		values[i] = r * cos(phi);
+		values[i + 1] = r * sin(phi);
+	}
+	if (n % 2)
+		values[n - 1] = randNorm();
+}
+
 double Random::randUniform(double min, double max) {
 	return min + (max - min) * rand();
 }
@@ -247,6 +263,12 @@ double Random::randExponential() {
 }
 
 uint32_t Random::randInt() {
+	if (counterBased) {
+		if ((counter & 3) == 0)
+			philox();
+		return block[counter++ & 3];
+	}
+
 	if (left == 0)
 		reload();
 	--left;
@@ -306,6 +328,75 @@ uint64_t Random::randInt64(const uint64_t &n)
 
 
 
+void Random::philox() {
+	// counter: stream id and block number, key: stream seed
+	uint64_t blockNumber = counter >> 2;
+	uint32_t c0 = uint32_t(stream), c1 = uint32_t(stream >> 32);
+	uint32_t c2 = uint32_t(blockNumber), c3 = uint32_t(blockNumber >> 32);
+	uint32_t k0 = uint32_t(streamSeed), k1 = uint32_t(streamSeed >> 32);
+
+	for (int round = 0; round < 10; round++) {
+		uint64_t p0 = uint64_t(0xD2511F53UL) * c0;
+		uint64_t p1 = uint64_t(0xCD9E8D57UL) * c2;
+		uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+		uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+		c1 = uint32_t(p1);
+		c3 = uint32_t(p0);
+		c0 = n0;
+		c2 = n2;
+		k0 += 0x9E3779B9UL;
+		k1 += 0xBB67AE85UL;
+	}
+
+	block[0] = c0;
+	block[1] = c1;
+	block[2] = c2;
+	block[3] = c3;
+}
+
+void Random::setStream(uint64_t s, uint64_t n) {
+	counterBased = true;
+	stream = s;
+	counter = n;
+	// continue within a partially used block
+	if ((counter & 3) != 0)
+		philox();
+}
+
+void Random::unsetStream() {
+	counterBased = false;
+}
+
+bool Random::isCounterBased() const {
+	return counterBased;
+}
+
+uint64_t Random::getStream() const {
+	return stream;
+}
+
+uint64_t Random::getStreamCounter() const {
+	return counter;
+}
+
+uint64_t Random::streamSeed = 0;
+
+void Random::setStreamSeed(uint64_t seed) {
+	streamSeed = seed;
+}
+
+uint64_t Random::getStreamSeed() {
+	return streamSeed;
+}
+
+uint64_t Random::deriveStream(uint64_t s, uint64_t n) {
+	// splitmix64 finalizer of a combination of stream and index
+	uint64_t z = s * 0x9E3779B97F4A7C15ULL + n + 1;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
 void Random::seed(const uint32_t oneSeed) {
 	initial_seed.resize(1);
 	initial_seed[0] = oneSeed;
@@ -0,0 +1,86 @@
+#include "crpropa/TableRegistry.h"
+
+#include <map>
+#include <utility>
+
+namespace crpropa {
+
+namespace {
+
+typedef std::pair<std::string, std::string> TableKey;
+typedef std::map<TableKey, ref_ptr<Referenced> > TableMap;
+
+TableMap &tableMap() {
+	static TableMap tables;
+	return tables;
+}
+
+bool enabled = true;
+
+// release tables only referenced by the registry
+void purge(TableMap &tables) {
+	TableMap::iterator i = tables.begin();
+	while (i != tables.end()) {
+		if (i->second->getReferenceCount() == 1)
+			tables.erase(i++);
+		else
+			++i;
+	}
+}
+
+} // namespace
+
+ref_ptr<Referenced> TableRegistry::findEntry(const std::string &kind, const std::string &field) {
+	ref_ptr<Referenced> entry;
+	if (!enabled)
+		return entry;
+#pragma omp critical(TableRegistry)
+	{
+		TableMap &tables = tableMap();
+		purge(tables);
+		TableMap::iterator i = tables.find(TableKey(kind, field));
+		if (i != tables.end())
+			entry = i->second;
+	}
+	return entry;
+}
+
+ref_ptr<Referenced> TableRegistry::insertEntry(const std::string &kind, const std::string &field, Referenced *tables) {
+	ref_ptr<Referenced> entry = tables;
+	if (!enabled or (tables == 0))
+		return entry;
+#pragma omp critical(TableRegistry)
+	{
+		TableMap &map = tableMap();
+		std::pair<TableMap::iterator, bool> result = map.insert(
+				TableMap::value_type(TableKey(kind, field), entry));
+		entry = result.first->second;
+	}
+	return entry;
+}
+
+size_t TableRegistry::size() {
+	size_t n;
+#pragma omp critical(TableRegistry)
+	{
+		TableMap &tables = tableMap();
+		purge(tables);
+		n = tables.size();
+	}
+	return n;
+}
+
+void TableRegistry::clear() {
+#pragma omp critical(TableRegistry)
+	tableMap().clear();
+}
+
+void TableRegistry::setEnabled(bool e) {
+	enabled = e;
+}
+
+bool TableRegistry::isEnabled() {
+	return enabled;
+}
+
+} // namespace crpropa
@@ -0,0 +1,82 @@
+#include "crpropa/UniformLogTable.h"
+
+#include <stdexcept>
+
+namespace crpropa {
+
+namespace {
+
+// true if the steps f(X[i+1]) - f(X[i]) for i >= first are all equal to the first one
+template<typename F>
+bool isEquidistant(const std::vector<double> &X, size_t first, F f, double tolerance) {
+	if (X.size() < first + 2)
+		return false;
+	double step = f(X[first + 1]) - f(X[first]);
+	if (not (step > 0))
+		return false;
+	for (size_t i = first + 1; i + 1 < X.size(); i++) {
+		double d = f(X[i + 1]) - f(X[i]);
+		if (std::fabs(d - step) > tolerance * step)
+			return false;
+	}
+	return true;
+}
+
+double identity(double x) {
+	return x;
+}
+
+double logarithm(double x) {
+	return std::log(x);
+}
+
+} // namespace
+
+UniformLogAxis::UniformLogAxis() :
+		spacing(Irregular), first(0), start(0), invStep(0) {
+}
+
+UniformLogAxis::UniformLogAxis(const std::vector<double> &X, double tolerance) :
+		X(X), spacing(Irregular), first(0), start(0), invStep(0) {
+	if (X.size() < 2)
+		throw std::runtime_error("UniformLogAxis: need at least two points");
+
+	if (isEquidistant(X, 0, identity, tolerance)) {
+		spacing = Linear;
+		start = X[0];
+		invStep = (X.size() - 1) / (X.back() - X.front());
+		return;
+	}
+
+	// logarithmic spacing, allowing for a leading 0
+	first = (X[0] == 0) ? 1 : 0;
+	if ((X[first] > 0) and isEquidistant(X, first, logarithm, tolerance)) {
+		spacing = Logarithmic;
+		start = std::log(X[first]);
+		invStep = (X.size() - 1 - first) / (std::log(X.back()) - start);
+		return;
+	}
+	first = 0;
+}
+
+UniformLogTable::UniformLogTable() {
+}
+
+UniformLogTable::UniformLogTable(const std::vector<double> &X,
+		const std::vector<double> &Y) :
+		axis(X), Y(Y) {
+	if (X.size() != Y.size())
+		throw std::runtime_error("UniformLogTable: X and Y must have the same size");
+}
+
+UniformLogTable2D::UniformLogTable2D() {
+}
+
+UniformLogTable2D::UniformLogTable2D(const std::vector<double> &X,
+		const std::vector<double> &Y, const std::vector<double> &Z) :
+		xAxis(X), yAxis(Y), Z(Z) {
+	if (X.size() * Y.size() != Z.size())
+		throw std::runtime_error("UniformLogTable2D: Z must have the size of X times Y");
+}
+
+} // namespace crpropa
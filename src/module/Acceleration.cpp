@@ -141,10 +141,10 @@ double QuasiLinearTheory::modify(double steplength, Candidate* candidate)
 }
 
 
-ParticleSplitting::ParticleSplitting(Surface *surface, int numSplits,
-		int	crossingThreshold, double minWeight, std::string counterid)
+ParticleSplitting::ParticleSplitting(Surface *surface, int crossingThreshold,
+		int numSplits, double minWeight, std::string counterid)
     : surface(surface), crossingThreshold(crossingThreshold),
-      numSplits(numSplits), minWeight(minWeight), counterid(counterid){};
+      numSplits(numSplits), minWeight(minWeight), counterid(PropertyKey(counterid)){};
 
 void ParticleSplitting::process(Candidate *candidate) const {
 	const double currentDistance =
@@ -167,9 +167,13 @@ void ParticleSplitting::process(Candidate *candidate) const {
 	if (num_crossings % crossingThreshold != 0)
 		return;
 
+	split(candidate, numSplits);
+};
+
+void ParticleSplitting::split(Candidate *candidate, int numSplits) {
 	candidate->setWeight(candidate->getWeight() / numSplits);
 
-	for (size_t i = 1; i < numSplits; i++) {
+	for (int i = 1; i < numSplits; i++) {
 		// No recursive split as the weights of the secondaries created
 		// before the split are not affected
 		ref_ptr<Candidate> new_candidate = candidate->clone(false);
@@ -0,0 +1,174 @@
+#include "crpropa/module/CompetingInteractions.h"
+#include "crpropa/Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace crpropa {
+
+CompetingInteractions::CompetingInteractions(double limit) :
+		particleClasses(0), limit(limit), eventDriven(false),
+		depthKey("InteractionDepth"), serialKey("InteractionDepthSerial") {
+}
+
+void CompetingInteractions::add(AbstractInteraction *interaction) {
+	if (channels.size() >= maxInteractions)
+		throw std::runtime_error("CompetingInteractions: too many interactions");
+	Channel channel;
+	channel.interaction = interaction;
+	channel.particleClasses = interaction->getParticleClasses();
+	channels.push_back(channel);
+	particleClasses |= channel.particleClasses;
+}
+
+size_t CompetingInteractions::size() const {
+	return channels.size();
+}
+
+AbstractInteraction *CompetingInteractions::get(size_t i) const {
+	return channels.at(i).interaction;
+}
+
+void CompetingInteractions::setLimit(double l) {
+	limit = l;
+}
+
+double CompetingInteractions::getLimit() const {
+	return limit;
+}
+
+void CompetingInteractions::setEventDriven(bool b) {
+	eventDriven = b;
+}
+
+bool CompetingInteractions::isEventDriven() const {
+	return eventDriven;
+}
+
+unsigned int CompetingInteractions::getParticleClasses() const {
+	return particleClasses;
+}
+
+void CompetingInteractions::process(Candidate *candidate) const {
+	if (eventDriven) {
+		processEventDriven(candidate);
+		return;
+	}
+
+	size_t n = channels.size();
+	double rates[maxInteractions];
+	double step = candidate->getCurrentStep();
+	Random &random = Random::instance();
+
+	// the loop is processed at least once for limiting the next step
+	do {
+		if (not candidate->isActive())
+			return;
+
+		// evaluate the rates of all interactions acting on the particle
+		unsigned int cls = particleClass(candidate->current.getId());
+		double totalRate = 0;
+		for (size_t i = 0; i < n; i++) {
+			const Channel &c = channels[i];
+			rates[i] = (c.particleClasses & cls) ? c.interaction->interactionRate(candidate) : 0;
+			totalRate += rates[i];
+		}
+		if (not (totalRate > 0))
+			return;
+
+		// check if an interaction happens in this step
+		double randDistance = -log(random.rand()) / totalRate;
+		if (step < randDistance) {
+			candidate->limitNextStep(limit / totalRate);
+			return;
+		}
+
+		// select the interaction by its share of the total rate
+		double cmp = random.rand() * totalRate;
+		size_t selected = 0;
+		for (size_t i = 0; i < n; i++) {
+			if (not (rates[i] > 0))
+				continue;
+			selected = i;
+			if (cmp < rates[i])
+				break;
+			cmp -= rates[i];
+		}
+		channels[selected].interaction->interact(candidate);
+
+		// repeat with remaining step
+		step -= randDistance;
+	} while (step > 0);
+}
+
+void CompetingInteractions::processEventDriven(Candidate *candidate) const {
+	size_t n = channels.size();
+	double rates[maxInteractions];
+	double step = candidate->getCurrentStep();
+	Random &random = Random::instance();
+
+	// remaining optical depth to the next interaction, drawn anew for candidates without one
+	double depth;
+	if (candidate->hasProperty(depthKey) and candidate->hasProperty(serialKey)
+			and (candidate->getProperty(serialKey).asUInt64() == candidate->getSerialNumber()))
+		depth = candidate->getProperty(depthKey).asDouble();
+	else
+		depth = -log(random.rand());
+
+	while (candidate->isActive()) {
+		// evaluate the rates of all interactions acting on the particle
+		unsigned int cls = particleClass(candidate->current.getId());
+		double totalRate = 0;
+		for (size_t i = 0; i < n; i++) {
+			const Channel &c = channels[i];
+			rates[i] = (c.particleClasses & cls) ? c.interaction->interactionRate(candidate) : 0;
+			totalRate += rates[i];
+		}
+		if (not (totalRate > 0))
+			break;
+
+		// no interaction in the rest of this step: step exactly to the next one
+		// (compared as distances, so that the limited step reaches it despite round-off)
+		if (step < depth / totalRate) {
+			depth -= step * totalRate;
+			candidate->limitNextStep(depth / totalRate);
+			break;
+		}
+
+		// select the interaction by its share of the total rate
+		double cmp = random.rand() * totalRate;
+		size_t selected = 0;
+		for (size_t i = 0; i < n; i++) {
+			if (not (rates[i] > 0))
+				continue;
+			selected = i;
+			if (cmp < rates[i])
+				break;
+			cmp -= rates[i];
+		}
+		channels[selected].interaction->interact(candidate);
+
+		// continue with the remaining step and a new optical depth
+		step = std::max(step - depth / totalRate, 0.);
+		depth = -log(random.rand());
+	}
+
+	candidate->setProperty(depthKey, Variant::fromDouble(depth));
+	candidate->setProperty(serialKey, Variant::fromUInt64(candidate->getSerialNumber()));
+}
+
+std::string CompetingInteractions::getDescription() const {
+	std::stringstream sstr;
+	sstr << "CompetingInteractions (";
+	for (size_t i = 0; i < channels.size(); i++) {
+		if (i > 0)
+			sstr << ", ";
+		sstr << channels[i].interaction->getDescription();
+	}
+	sstr << ")";
+	return sstr.str();
+}
+
+} // namespace crpropa
@@ -1,5 +1,7 @@
 #include "crpropa/module/DiffusionSDE.h"
 
+#include <algorithm>
+
 
 using namespace crpropa;
 
@@ -91,12 +93,6 @@ void DiffusionSDE::process(Candidate *candidate) const {
 	double NStep = BTensor[4] * eta[1];
 	double BStep = BTensor[8] * eta[2];
 
-	Vector3d TVec(0.);
-	Vector3d NVec(0.);
-	Vector3d BVec(0.);
-
-	Vector3d DirOut = Vector3d(0.);
-
 
 	double propTime = TStep * sqrt(h) / c_light;
 	size_t counter = 0;
@@ -125,6 +121,172 @@ void DiffusionSDE::process(Candidate *candidate) const {
 		Start = PosOut;
 	}
 
+	finishStep(candidate, PosIn, PosOut, h, TStep, NStep, BStep, stepNumber);
+}
+
+void DiffusionSDE::processBatch(Candidate **candidates, size_t n) const {
+	Candidate *lanes[batchWidth];
+	size_t m = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (candidates[i]->current.getCharge() == 0) {
+			DiffusionSDE::process(candidates[i]);
+			continue;
+		}
+		lanes[m++] = candidates[i];
+		if (m == batchWidth) {
+			processLanes(lanes, m);
+			m = 0;
+		}
+	}
+	if (m > 0)
+		processLanes(lanes, m);
+}
+
+void DiffusionSDE::processLanes(Candidate **candidates, size_t m) const {
+	const size_t W = batchWidth;
+	// positions in structure-of-arrays layout, one lane per pseudo-particle
+	double posIn[3][W], start[3][W], posOut[3][W], posErr[3][W];
+	double h[W], z[W], TStep[W], NStep[W], BStep[W], propTime[W];
+	size_t counter[W], stepNumber[W];
+	bool pending[W];
+
+	// normal variates of all lanes in one call
+	double eta[3 * W];
+	Random::instance().randNormArray(eta, 3 * m);
+
+	for (size_t l = 0; l < W; l++) {
+		// unused lanes repeat the first candidate and are never pending
+		Candidate *candidate = candidates[(l < m) ? l : 0];
+		ParticleState &current = candidate->current;
+		if (l < m)
+			candidate->previous = current;
+
+		h[l] = clip(candidate->getNextStep(), minStep, maxStep) / c_light;
+		z[l] = candidate->getRedshift();
+		Vector3d pos = current.getPosition();
+		posIn[0][l] = pos.x;
+		posIn[1][l] = pos.y;
+		posIn[2][l] = pos.z;
+
+		double BTensor[] = {0., 0., 0., 0., 0., 0., 0., 0., 0.};
+		double rig = current.getEnergy() / current.getCharge();
+		calculateBTensor(rig, BTensor, pos, current.getDirection(), z[l]);
+		size_t i = (l < m) ? l : 0;
+		TStep[l] = BTensor[0] * eta[3 * i];
+		NStep[l] = BTensor[4] * eta[3 * i + 1];
+		BStep[l] = BTensor[8] * eta[3 * i + 2];
+
+		propTime[l] = TStep[l] * sqrt(h[l]) / c_light;
+		counter[l] = (l < m) ? 0 : 1;
+		pending[l] = (l < m);
+	}
+
+	// halve the time of each lane until its field line step reaches the tolerance
+	size_t nPending = m;
+	while (nPending > 0) {
+		tryStepLanes(posIn, posOut, posErr, z, propTime, pending);
+		for (size_t l = 0; l < W; l++) {
+			if (not pending[l])
+				continue;
+			double r = sqrt(posErr[0][l] * posErr[0][l] + posErr[1][l] * posErr[1][l]
+					+ posErr[2][l] * posErr[2][l]) / tolerance;
+			propTime[l] *= 0.5;
+			counter[l] += 1;
+			if (not (r > 1 && fabs(propTime[l]) >= minStep / c_light)) {
+				pending[l] = false;
+				nPending--;
+			}
+		}
+	}
+
+	// integrate the field lines with the accepted number of sub-steps
+	size_t maxStepNumber = 0;
+	for (size_t l = 0; l < W; l++) {
+		stepNumber[l] = pow(2, counter[l] - 1);
+		propTime[l] = TStep[l] * sqrt(h[l]) / c_light / stepNumber[l];
+		for (size_t c = 0; c < 3; c++)
+			start[c][l] = posIn[c][l];
+		if (l < m)
+			maxStepNumber = std::max(maxStepNumber, stepNumber[l]);
+	}
+	for (size_t j = 0; j < maxStepNumber; j++) {
+		for (size_t l = 0; l < W; l++)
+			pending[l] = (l < m) and (j < stepNumber[l]);
+		tryStepLanes(start, posOut, posErr, z, propTime, pending);
+		for (size_t c = 0; c < 3; c++)
+			for (size_t l = 0; l < W; l++)
+				if (pending[l])
+					start[c][l] = posOut[c][l];
+	}
+
+	for (size_t l = 0; l < m; l++) {
+		Vector3d PosIn(posIn[0][l], posIn[1][l], posIn[2][l]);
+		Vector3d PosOut(start[0][l], start[1][l], start[2][l]);
+		finishStep(candidates[l], PosIn, PosOut, h[l], TStep[l], NStep[l], BStep[l], stepNumber[l]);
+	}
+}
+
+void DiffusionSDE::tryStepLanes(const double PosIn[3][batchWidth], double POut[3][batchWidth],
+		double PosErr[3][batchWidth], const double z[batchWidth],
+		const double propStep[batchWidth], const bool active[batchWidth]) const {
+	const size_t W = batchWidth;
+	double yn[3][W], k[6][3][W];
+
+	for (size_t c = 0; c < 3; c++) {
+		for (size_t l = 0; l < W; l++) {
+			POut[c][l] = PosIn[c][l];
+			PosErr[c][l] = 0;
+		}
+	}
+
+	for (size_t i = 0; i < 6; i++) {
+		for (size_t c = 0; c < 3; c++) {
+			for (size_t l = 0; l < W; l++)
+				yn[c][l] = PosIn[c][l];
+			for (size_t j = 0; j < i; j++) {
+				double aij = a[i * 6 + j];
+				for (size_t l = 0; l < W; l++)
+					yn[c][l] += k[j][c][l] * aij * propStep[l];
+			}
+		}
+
+		// direction of the regular magnetic field for the active lanes
+		for (size_t l = 0; l < W; l++) {
+			Vector3d BField(0.);
+			if (active[l]) {
+				try {
+					BField = magneticField->getField(Vector3d(yn[0][l], yn[1][l], yn[2][l]), z[l]);
+				}
+				catch (std::exception &e) {
+					KISS_LOG_ERROR 	<< "DiffusionSDE: Exception in magneticField::getField.\n"
+							<< e.what();
+				}
+			}
+			Vector3d dir = BField.getUnitVector() * c_light;
+			k[i][0][l] = dir.x;
+			k[i][1][l] = dir.y;
+			k[i][2][l] = dir.z;
+		}
+
+		double bi = b[i];
+		double ei = b[i] - bs[i];
+		for (size_t c = 0; c < 3; c++) {
+			for (size_t l = 0; l < W; l++) {
+				POut[c][l] += k[i][c][l] * bi * propStep[l];
+				PosErr[c][l] += k[i][c][l] * ei * propStep[l] / kpc;
+			}
+		}
+	}
+}
+
+void DiffusionSDE::finishStep(Candidate *candidate, const Vector3d &PosIn, const Vector3d &PosOut,
+		double h, double TStep, double NStep, double BStep, size_t stepNumber) const {
+	ParticleState &current = candidate->current;
+	Vector3d TVec(0.);
+	Vector3d NVec(0.);
+	Vector3d BVec(0.);
+	Vector3d DirOut = Vector3d(0.);
+
     // Normalize the tangent vector
 	TVec = (PosOut-PosIn).getUnitVector();
     // Exception: If the magnetic field vanishes: Use only advection.
@@ -10,10 +10,30 @@
 #include <iomanip>
 #include <stdexcept>
 #include <cmath>
+#include <limits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace crpropa {
 
-EMCascade::EMCascade() : nE(170), logEmin(7), logEmax(24), dlogE(0.1) {
+namespace {
+
+const size_t maxThreads = 256; // as for the random number generators
+
+size_t threadIndex() {
+#ifdef _OPENMP
+	return omp_get_thread_num();
+#else
+	return 0;
+#endif
+}
+
+} // namespace
+
+EMCascade::EMCascade() : nE(170), logEmin(7), logEmax(24), dlogE(0.1),
+		maximumEnergy(std::numeric_limits<double>::max()) {
 	setDistanceBinning(1000 * Mpc, 1000);
 }
 
@@ -24,26 +44,59 @@ void EMCascade::setDistanceBinning(double Dmax, int nD) {
 	init();
 }
 
+void EMCascade::setMaximumEnergy(double energy) {
+	maximumEnergy = energy;
+}
+
+double EMCascade::getMaximumEnergy() const {
+	return maximumEnergy;
+}
+
 void EMCascade::init() {
-	photonHist.reserve(nD * nE);
-	photonHist.assign(nD * nE, 0);
-	electronHist.reserve(nD * nE);
-	electronHist.assign(nD * nE, 0);
-	positronHist.reserve(nD * nE);
-	positronHist.assign(nD * nE, 0);
+	// the histograms of the threads are allocated on their first use
+	histograms.assign(maxThreads, std::vector<double>());
+}
+
+std::vector<double> &EMCascade::threadHistogram() const {
+	size_t i = threadIndex();
+	if (i >= histograms.size())
+		throw std::runtime_error("EMCascade: more than 256 threads");
+	std::vector<double> &h = histograms[i];
+	if (h.empty())
+		h.assign(3 * nD * nE, 0.);
+	return h;
+}
+
+std::vector<double> EMCascade::sumHistograms() const {
+	std::vector<double> sum(3 * nD * nE, 0.);
+	for (size_t t = 0; t < histograms.size(); t++) {
+		const std::vector<double> &h = histograms[t];
+		for (size_t i = 0; i < h.size(); i++)
+			sum[i] += h[i];
+	}
+	return sum;
 }
 
 std::string EMCascade::getDescription() const {
 	std::stringstream s;
 	s << "EMCascade";
+	if (maximumEnergy < std::numeric_limits<double>::max())
+		s << " for particles below " << maximumEnergy / eV << " eV";
 	return s.str();
 }
 
+unsigned int EMCascade::getParticleClasses() const {
+	return ParticleClassPhoton | ParticleClassElectron;
+}
+
 void EMCascade::process(Candidate *candidate) const {
 	int id = candidate->current.getId();
 	if ((id != 22) and (id != 11) and (id != -11))
 		return;
 
+	if (candidate->current.getEnergy() > maximumEnergy)
+		return;
+
 	candidate->setActive(false);
 
 	double logE = log10(candidate->current.getEnergy() / eV);
@@ -56,17 +109,8 @@ void EMCascade::process(Candidate *candidate) const {
 
 	int iE = (logE - logEmin) / dlogE;
 	int iD = D / dD;
-	int i = (iD * nE) + iE;
-
-#pragma omp critical
-	{
-	if (id == 22)
-		photonHist[i] += 1;
-	else if (id == 11)
-		electronHist[i] += 1;
-	else
-		positronHist[i] += 1;
-	}
+	int species = (id == 22) ? 0 : ((id == 11) ? 1 : 2);
+	threadHistogram()[(species * nD + iD) * nE + iE] += candidate->getWeight();
 }
 
 void EMCascade::save(const std::string &filename) {
@@ -76,6 +120,8 @@ void EMCascade::save(const std::string &filename) {
 		s << "EMCascade: could not open " << filename;
 		throw std::runtime_error(s.str());
 	}
+	std::vector<double> hist = sumHistograms();
+	size_t n = nD * nE;
 	outfile << "# D/Mpc log10(E/eV) nPhotons nElectrons nPositrons\n";
 	for (int i = 0; i < (nD * nE); i++) {
 		div_t divresult = div(i, nE);
@@ -83,9 +129,9 @@ void EMCascade::save(const std::string &filename) {
 		double logE = logEmin + (divresult.rem + 0.5) * dlogE;
 		outfile << D << "\t";
 		outfile << logE << "\t";
-		outfile << photonHist[i] << "\t";
-		outfile << electronHist[i] << "\t";
-		outfile << positronHist[i] << "\n";
+		outfile << hist[i] << "\t";
+		outfile << hist[n + i] << "\t";
+		outfile << hist[2 * n + i] << "\n";
 	}
 	outfile.close();
 }
@@ -99,14 +145,16 @@ void EMCascade::load(const std::string &filename) {
 	}
 
 	infile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');  // skip header
+	std::vector<double> &hist = threadHistogram();
+	size_t n = nD * nE;
 	double D, lE, h1, h2, h3;
 	for (int i = 0; i < (nD * nE); i++) {
 		infile >> D >> lE >> h1 >> h2 >> h3;
 		if (!infile.good())
 			throw std::runtime_error("EMCascde: error reading file");
-		photonHist[i] += h1;
-		electronHist[i] += h2;
-		positronHist[i] += h3;
+		hist[i] += h1;
+		hist[n + i] += h2;
+		hist[2 * n + i] += h3;
 	}
 	infile.close();
 }
@@ -125,6 +173,10 @@ void EMCascade::runCascade(const std::string &filename, int IRBFlag,
 	NewSpectrum(&outputSpectrum, nE);
 	InitializeSpectrum(&outputSpectrum);
 
+	// histograms of all threads
+	std::vector<double> hist = sumHistograms();
+	size_t n = nD * nE;
+
 	// step-wise cascade calculation
 	for (int iD = nD - 1; iD >= 0; iD--) {
 		// make output of previous step the new input and reset output
@@ -135,9 +187,9 @@ void EMCascade::runCascade(const std::string &filename, int IRBFlag,
 		double count = 0;
 		for (int iE = 0; iE < nE; iE++) {
 			int i = (iD * nE) + iE;
-			inputSpectrum.spectrum[PHOTON][iE] += photonHist[i];
-			inputSpectrum.spectrum[ELECTRON][iE] += electronHist[i];
-			inputSpectrum.spectrum[POSITRON][iE] += positronHist[i];
+			inputSpectrum.spectrum[PHOTON][iE] += hist[i];
+			inputSpectrum.spectrum[ELECTRON][iE] += hist[n + i];
+			inputSpectrum.spectrum[POSITRON][iE] += hist[2 * n + i];
 			count += inputSpectrum.spectrum[PHOTON][iE];
 			count += inputSpectrum.spectrum[ELECTRON][iE];
 			count += inputSpectrum.spectrum[POSITRON][iE];
@@ -170,10 +222,8 @@ void EMCascade::runCascade(const std::string &filename, int IRBFlag,
 	}
 	outfile.close();
 
-	// clear the histogram
-	photonHist.assign(nD * nE, 0);
-	electronHist.assign(nD * nE, 0);
-	positronHist.assign(nD * nE, 0);
+	// clear the histograms
+	init();
 
 	DeleteSpectrum(&outputSpectrum);
 	DeleteSpectrum(&inputSpectrum);
@@ -1,5 +1,6 @@
 #include "crpropa/module/EMDoublePairProduction.h"
 #include "crpropa/Units.h"
+#include "crpropa/TableRegistry.h"
 #include "crpropa/Random.h"
 
 #include <fstream>
@@ -19,7 +20,11 @@ void EMDoublePairProduction::setPhotonField(ref_ptr<PhotonField> photonField) {
 	this->photonField = photonField;
 	std::string fname = photonField->getFieldName();
 	setDescription("EMDoublePairProduction: " + fname);
-	initRate(getDataPath("EMDoublePairProduction/rate_" + fname + ".txt"));
+	if (!TableRegistry::find("EMDoublePairProduction", fname, tables)) {
+		tables = new Tables();
+		initRate(getDataPath("EMDoublePairProduction/rate_" + fname + ".txt"));
+		TableRegistry::insert("EMDoublePairProduction", fname, tables);
+	}
 }
 
 void EMDoublePairProduction::setHaveElectrons(bool haveElectrons) {
@@ -40,22 +45,27 @@ void EMDoublePairProduction::initRate(std::string filename) {
 	if (!infile.good())
 		throw std::runtime_error("EMDoublePairProduction: could not open file " + filename);
 
+	TableRegistry::detach(tables);
+
 	// clear previously loaded interaction rates
-	tabEnergy.clear();
-	tabRate.clear();
+	tables->tabEnergy.clear();
+	tables->tabRate.clear();
 
 	while (infile.good()) {
 		if (infile.peek() != '#') {
 			double a, b;
 			infile >> a >> b;
 			if (infile) {
-				tabEnergy.push_back(pow(10, a) * eV);
-				tabRate.push_back(b / Mpc);
+				tables->tabEnergy.push_back(pow(10, a) * eV);
+				tables->tabRate.push_back(b / Mpc);
 			}
 		}
 		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
 	}
 	infile.close();
+
+	if (tables->tabEnergy.size() > 1)
+		tables->rate = UniformLogTable(tables->tabEnergy, tables->tabRate);
 }
 
 
@@ -91,22 +101,37 @@ void EMDoublePairProduction::performInteraction(Candidate *candidate) const {
 	}
 }
 
-void EMDoublePairProduction::process(Candidate *candidate) const {
+unsigned int EMDoublePairProduction::getParticleClasses() const {
+	return ParticleClassPhoton;
+}
+
+double EMDoublePairProduction::interactionRate(const Candidate *candidate) const {
 	// check if photon
 	if (candidate->current.getId() != 22)
-		return;
+		return 0;
 
 	// scale the electron energy instead of background photons
 	double z = candidate->getRedshift();
 	double E = (1 + z) * candidate->current.getEnergy();
 
 	// check if in tabulated energy range
-	if (E < tabEnergy.front() or (E > tabEnergy.back()))
-		return;
+	if (E < tables->tabEnergy.front() or (E > tables->tabEnergy.back()))
+		return 0;
 
 	// interaction rate
-	double rate = interpolate(E, tabEnergy, tabRate);
+	double rate = tables->rate.interpolate(E);
 	rate *= pow_integer<2>(1 + z) * photonField->getRedshiftScaling(z);
+	return rate;
+}
+
+void EMDoublePairProduction::interact(Candidate *candidate) const {
+	performInteraction(candidate);
+}
+
+void EMDoublePairProduction::process(Candidate *candidate) const {
+	double rate = interactionRate(candidate);
+	if (rate <= 0)
+		return;
 
 	// check for interaction
 	Random &random = Random::instance();
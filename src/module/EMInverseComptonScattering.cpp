@@ -1,9 +1,10 @@
 #include "crpropa/module/EMInverseComptonScattering.h"
 #include "crpropa/Units.h"
+#include "crpropa/TableRegistry.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/Random.h"
 #include "crpropa/Common.h"
 
-#include <fstream>
 #include <limits>
 #include <stdexcept>
 
@@ -11,19 +12,27 @@ namespace crpropa {
 
 static const double mec2 = mass_electron * c_squared;
 
+class ICSSecondariesEnergyDistribution;
+static const ICSSecondariesEnergyDistribution &secondariesEnergyDistribution();
+
 EMInverseComptonScattering::EMInverseComptonScattering(ref_ptr<PhotonField> photonField, bool havePhotons, double thinning, double limit) {
 	setPhotonField(photonField);
 	setHavePhotons(havePhotons);
 	setLimit(limit);
 	setThinning(thinning);
+	secondariesEnergyDistribution(); // build the sampling tables eagerly
 }
 
 void EMInverseComptonScattering::setPhotonField(ref_ptr<PhotonField> photonField) {
 	this->photonField = photonField;
 	std::string fname = photonField->getFieldName();
 	setDescription("EMInverseComptonScattering: " + fname);
-	initRate(getDataPath("EMInverseComptonScattering/rate_" + fname + ".txt"));
-	initCumulativeRate(getDataPath("EMInverseComptonScattering/cdf_" + fname + ".txt"));
+	if (!TableRegistry::find("EMInverseComptonScattering", fname, tables)) {
+		tables = new Tables();
+		initRate(getDataPath("EMInverseComptonScattering/rate_" + fname + ".txt"));
+		initCumulativeRate(getDataPath("EMInverseComptonScattering/cdf_" + fname + ".txt"));
+		TableRegistry::insert("EMInverseComptonScattering", fname, tables);
+	}
 }
 
 void EMInverseComptonScattering::setHavePhotons(bool havePhotons) {
@@ -39,73 +48,66 @@ void EMInverseComptonScattering::setThinning(double thinning) {
 }
 
 void EMInverseComptonScattering::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
+	DataTable table(filename);
+	if (!table.good())
 		throw std::runtime_error("EMInverseComptonScattering: could not open file " + filename);
 
+	TableRegistry::detach(tables);
+
 	// clear previously loaded tables
-	tabEnergy.clear();
-	tabRate.clear();
-
-	while (infile.good()) {
-		if (infile.peek() != '#') {
-			double a, b;
-			infile >> a >> b;
-			if (infile) {
-				tabEnergy.push_back(pow(10, a) * eV);
-				tabRate.push_back(b / Mpc);
-			}
-		}
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
+	tables->tabEnergy.clear();
+	tables->tabRate.clear();
+
+	// rows: log10(energy / eV), rate
+	for (size_t i = 0; i < table.rows(); i++) {
+		if (table.columns(i) < 2)
+			continue;
+		tables->tabEnergy.push_back(pow(10, table.get(i, 0)) * eV);
+		tables->tabRate.push_back(table.get(i, 1) / Mpc);
 	}
-	infile.close();
+
+	if (tables->tabEnergy.size() > 1)
+		tables->rate = UniformLogTable(tables->tabEnergy, tables->tabRate);
 }
 
 void EMInverseComptonScattering::initCumulativeRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-
-	if (!infile.good())
+	DataTable table(filename);
+	if (!table.good())
 		throw std::runtime_error("EMInverseComptonScattering: could not open file " + filename);
 
+	TableRegistry::detach(tables);
+
 	// clear previously loaded tables
-	tabE.clear();
-	tabs.clear();
-	tabCDF.clear();
-	
-	// skip header
-	while (infile.peek() == '#')
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
-
-	// read s values in first line
-	double a;
-	infile >> a; // skip first value
-	while (infile.good() and (infile.peek() != '\n')) {
-		infile >> a;
-		tabs.push_back(pow(10, a) * eV * eV);
-	}
+	tables->tabE.clear();
+	tables->tabs.clear();
+	tables->tabCDF.clear();
+	tables->sBins = AliasTable();
 
-	// read all following lines: E, cdf values
-	while (infile.good()) {
-		infile >> a;
-		if (!infile)
-			break;  // end of file
-		tabE.push_back(pow(10, a) * eV);
-		std::vector<double> cdf;
-		for (int i = 0; i < tabs.size(); i++) {
-			infile >> a;
-			cdf.push_back(a / Mpc);
-		}
-		tabCDF.push_back(cdf);
+	if (table.rows() == 0)
+		return;
+
+	// s values in first row, skipping the first value
+	for (size_t j = 1; j < table.columns(0); j++)
+		tables->tabs.push_back(pow(10, table.get(0, j)) * eV * eV);
+
+	// all following rows: E, cdf values
+	for (size_t i = 1; i < table.rows(); i++) {
+		if (table.columns(i) < 1 + tables->tabs.size())
+			throw std::runtime_error("EMInverseComptonScattering: incomplete row in " + filename);
+		const double *row = table.row(i);
+		tables->tabE.push_back(pow(10, row[0]) * eV);
+		std::vector<double> cdf(tables->tabs.size());
+		for (size_t j = 0; j < tables->tabs.size(); j++)
+			cdf[j] = row[1 + j] / Mpc;
+		tables->tabCDF.push_back(cdf);
+		tables->sBins.add(cdf);
 	}
-	infile.close();
 }
 
 // Class to calculate the energy distribution of the ICS photon and to sample from it
 class ICSSecondariesEnergyDistribution {
 	private:
-		std::vector< std::vector<double> > data;
-		std::vector<double> s_values;
+		AliasTable data; // one distribution per s bin
 		size_t Ns;
 		size_t Nrer;
 		double s_min;
@@ -126,15 +128,8 @@ class ICSSecondariesEnergyDistribution {
 			s_min = mec2 * mec2;
 			s_max = 1e23 * eV * eV;
 			dls = (log(s_max) - log(s_min)) / Ns;
-			data = std::vector< std::vector<double> >(1000, std::vector<double>(1000));
 			std::vector<double> data_i(1000);
 
-			// tabulate s bin borders
-			s_values = std::vector<double>(1001);
-			for (size_t i = 0; i < Ns + 1; ++i)
-				s_values[i] = s_min * exp(i*dls);
-
-
 			// for each s tabulate cumulative differential cross section
 			for (size_t i = 0; i < Ns; i++) {
 				double s = s_min * exp((i+0.5) * dls);
@@ -150,16 +145,17 @@ class ICSSecondariesEnergyDistribution {
 					data_i[j] = dSigmadE(x, beta) * dx;
 					data_i[j] += data_i[j-1];
 				}
-				data[i] = data_i;
+				data.add(data_i);
 			}
 		}
 
 		// draw random energy for the up-scattered photon Ep(Ee, s)
-		double sample(double Ee, double s) {
-			size_t idx = std::lower_bound(s_values.begin(), s_values.end(), s) - s_values.begin();
-			std::vector<double> s0 = data[idx];
+		double sample(double Ee, double s) const {
+			// s bin containing s, logarithmic bins from s_min
+			double ls = log(s / s_min) / dls;
+			size_t idx = (ls > 0) ? std::min(size_t(ls), Ns - 1) : 0;
 			Random &random = Random::instance();
-			size_t j = random.randBin(s0) + 1; // draw random bin (upper bin boundary returned)
+			size_t j = data.sample(idx, random) + 1; // draw random bin (upper bin boundary returned)
 			double beta = (s - s_min) / (s + s_min);
 			double x0 = (1 - beta) / (1 + beta);
 			double dlx = -log(x0) / Nrer;
@@ -169,24 +165,29 @@ class ICSSecondariesEnergyDistribution {
 		}
 };
 
+// shared instance, built when the first module is constructed
+static const ICSSecondariesEnergyDistribution &secondariesEnergyDistribution() {
+	static ICSSecondariesEnergyDistribution distribution;
+	return distribution;
+}
+
 void EMInverseComptonScattering::performInteraction(Candidate *candidate) const {
 	// scale the particle energy instead of background photons
 	double z = candidate->getRedshift();
 	double E = candidate->current.getEnergy() * (1 + z);
 
-	if (E < tabE.front() or E > tabE.back())
+	if (E < tables->tabE.front() or E > tables->tabE.back())
 		return;
 
 	// sample the value of s
 	Random &random = Random::instance();
-	size_t i = closestIndex(E, tabE);
-	size_t j = random.randBin(tabCDF[i]);
-	double s_kin = pow(10, log10(tabs[j]) + (random.rand() - 0.5) * 0.1);
+	size_t i = closestIndex(E, tables->tabE);
+	size_t j = tables->sBins.sample(i, random);
+	double s_kin = pow(10, log10(tables->tabs[j]) + (random.rand() - 0.5) * 0.1);
 	double s = s_kin + mec2 * mec2;
 
 	// sample electron energy after scattering
-	static ICSSecondariesEnergyDistribution distribution;
-	double Enew = distribution.sample(E, s);
+	double Enew = secondariesEnergyDistribution().sample(E, s);
 
 	// add up-scattered photon
 	double Esecondary = E - Enew;
@@ -204,22 +205,37 @@ void EMInverseComptonScattering::performInteraction(Candidate *candidate) const
 	candidate->current.setEnergy(Enew / (1 + z));
 }
 
-void EMInverseComptonScattering::process(Candidate *candidate) const {
+unsigned int EMInverseComptonScattering::getParticleClasses() const {
+	return ParticleClassElectron;
+}
+
+double EMInverseComptonScattering::interactionRate(const Candidate *candidate) const {
 	// check if electron / positron
 	int id = candidate->current.getId();
 	if (abs(id) != 11)
-		return;
+		return 0;
 
 	// scale the particle energy instead of background photons
 	double z = candidate->getRedshift();
 	double E = candidate->current.getEnergy() * (1 + z);
 
-	if (E < tabEnergy.front() or (E > tabEnergy.back()))
-		return;
+	if (E < tables->tabEnergy.front() or (E > tables->tabEnergy.back()))
+		return 0;
 
 	// interaction rate
-	double rate = interpolate(E, tabEnergy, tabRate);
+	double rate = tables->rate.interpolate(E);
 	rate *= pow_integer<2>(1 + z) * photonField->getRedshiftScaling(z);
+	return rate;
+}
+
+void EMInverseComptonScattering::interact(Candidate *candidate) const {
+	performInteraction(candidate);
+}
+
+void EMInverseComptonScattering::process(Candidate *candidate) const {
+	double rate = interactionRate(candidate);
+	if (rate <= 0)
+		return;
 
 	// run this loop at least once to limit the step size
 	double step = candidate->getCurrentStep();
@@ -1,5 +1,6 @@
 #include "crpropa/module/EMPairProduction.h"
 #include "crpropa/Units.h"
+#include "crpropa/TableRegistry.h"
 #include "crpropa/Random.h"
 
 #include <fstream>
@@ -11,19 +12,27 @@ namespace crpropa {
 
 static const double mec2 = mass_electron * c_squared;
 
+class PPSecondariesEnergyDistribution;
+static const PPSecondariesEnergyDistribution &secondariesEnergyDistribution();
+
 EMPairProduction::EMPairProduction(ref_ptr<PhotonField> photonField, bool haveElectrons, double thinning, double limit) {
 	setPhotonField(photonField);
 	setThinning(thinning);
 	setLimit(limit);
 	setHaveElectrons(haveElectrons);
+	secondariesEnergyDistribution(); // build the sampling tables eagerly
 }
 
 void EMPairProduction::setPhotonField(ref_ptr<PhotonField> photonField) {
 	this->photonField = photonField;
 	std::string fname = photonField->getFieldName();
 	setDescription("EMPairProduction: " + fname);
-	initRate(getDataPath("EMPairProduction/rate_" + fname + ".txt"));
-	initCumulativeRate(getDataPath("EMPairProduction/cdf_" + fname + ".txt"));
+	if (!TableRegistry::find("EMPairProduction", fname, tables)) {
+		tables = new Tables();
+		initRate(getDataPath("EMPairProduction/rate_" + fname + ".txt"));
+		initCumulativeRate(getDataPath("EMPairProduction/cdf_" + fname + ".txt"));
+		TableRegistry::insert("EMPairProduction", fname, tables);
+	}
 }
 
 void EMPairProduction::setHaveElectrons(bool haveElectrons) {
@@ -44,22 +53,27 @@ void EMPairProduction::initRate(std::string filename) {
 	if (!infile.good())
 		throw std::runtime_error("EMPairProduction: could not open file " + filename);
 
+	TableRegistry::detach(tables);
+
 	// clear previously loaded interaction rates
-	tabEnergy.clear();
-	tabRate.clear();
+	tables->tabEnergy.clear();
+	tables->tabRate.clear();
 
 	while (infile.good()) {
 		if (infile.peek() != '#') {
 			double a, b;
 			infile >> a >> b;
 			if (infile) {
-				tabEnergy.push_back(pow(10, a) * eV);
-				tabRate.push_back(b / Mpc);
+				tables->tabEnergy.push_back(pow(10, a) * eV);
+				tables->tabRate.push_back(b / Mpc);
 			}
 		}
 		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
 	}
 	infile.close();
+
+	if (tables->tabEnergy.size() > 1)
+		tables->rate = UniformLogTable(tables->tabEnergy, tables->tabRate);
 }
 
 void EMPairProduction::initCumulativeRate(std::string filename) {
@@ -68,10 +82,13 @@ void EMPairProduction::initCumulativeRate(std::string filename) {
 	if (!infile.good())
 		throw std::runtime_error("EMPairProduction: could not open file " + filename);
 
+	TableRegistry::detach(tables);
+
 	// clear previously loaded tables
-	tabE.clear();
-	tabs.clear();
-	tabCDF.clear();
+	tables->tabE.clear();
+	tables->tabs.clear();
+	tables->tabCDF.clear();
+	tables->sBins = AliasTable();
 	
 	// skip header
 	while (infile.peek() == '#')
@@ -82,7 +99,7 @@ void EMPairProduction::initCumulativeRate(std::string filename) {
 	infile >> a; // skip first value
 	while (infile.good() and (infile.peek() != '\n')) {
 		infile >> a;
-		tabs.push_back(pow(10, a) * eV * eV);
+		tables->tabs.push_back(pow(10, a) * eV * eV);
 	}
 
 	// read all following lines: E, cdf values
@@ -90,23 +107,26 @@ void EMPairProduction::initCumulativeRate(std::string filename) {
 		infile >> a;
 		if (!infile)
 			break;  // end of file
-		tabE.push_back(pow(10, a) * eV);
+		tables->tabE.push_back(pow(10, a) * eV);
 		std::vector<double> cdf;
-		for (int i = 0; i < tabs.size(); i++) {
+		for (int i = 0; i < tables->tabs.size(); i++) {
 			infile >> a;
 			cdf.push_back(a / Mpc);
 		}
-		tabCDF.push_back(cdf);
+		tables->tabCDF.push_back(cdf);
+		tables->sBins.add(cdf);
 	}
 	infile.close();
 }
 
-// Hold an data array to interpolate the energy distribution on
+// Hold alias tables of the energy distribution for each s bin
 class PPSecondariesEnergyDistribution {
 	private:
-		std::vector<double> tab_s;
-		std::vector< std::vector<double> > data;
+		AliasTable data;
 		size_t N;
+		size_t Ns;
+		double s_min;
+		double dls;
 
 	public:
 		// differential cross section for pair production for x = Epositron/Egamma, compare Lee 96 arXiv:9604098
@@ -119,15 +139,10 @@ class PPSecondariesEnergyDistribution {
 
 		PPSecondariesEnergyDistribution() {
 			N = 1000;
-			size_t Ns = 1000;
-			double s_min = 4 * mec2 * mec2;
+			Ns = 1000;
+			s_min = 4 * mec2 * mec2;
 			double s_max = 1e23 * eV * eV;
-			double dls = log(s_max / s_min) / Ns;
-			data = std::vector< std::vector<double> >(Ns, std::vector<double>(N));
-			tab_s = std::vector<double>(Ns + 1);
-
-			for (size_t i = 0; i < Ns + 1; ++i)
-				tab_s[i] = s_min * exp(i*dls); // tabulate s bin borders
+			dls = log(s_max / s_min) / Ns;
 
 			for (size_t i = 0; i < Ns; i++) {
 				double s = s_min * exp(i*dls + 0.5*dls);
@@ -143,21 +158,20 @@ class PPSecondariesEnergyDistribution {
 					double binWidth = exp((j+1)*dx)-exp(j*dx);
 					data_i[j] = dSigmadE_PPx(x, beta) * binWidth + data_i[j-1];
 				}
-				data[i] = data_i;
+				data.add(data_i);
 			}
 		}
 
 		// sample positron energy from cdf(E, s_kin)
-		double sample(double E0, double s) {
-			// get distribution for given s
-			size_t idx = std::lower_bound(tab_s.begin(), tab_s.end(), s) - tab_s.begin();
-			std::vector<double> s0 = data[idx];
+		double sample(double E0, double s) const {
+			// get distribution for the s bin (logarithmic bins from s_min)
+			double ls = log(s / s_min) / dls;
+			size_t idx = (ls > 0) ? std::min(size_t(ls), Ns - 1) : 0;
 
 			// draw random bin
 			Random &random = Random::instance();
-			size_t j = random.randBin(s0) + 1;
+			size_t j = data.sample(idx, random) + 1;
 
-			double s_min = 4. * mec2 * mec2;
 			double beta = sqrtl(1. - s_min / s);
 			double x0 = (1. - beta) / 2.;
 			double dx = log((1 + beta) / (1 - beta)) / N;
@@ -169,6 +183,12 @@ class PPSecondariesEnergyDistribution {
 		}
 };
 
+// shared instance, built when the first module is constructed
+static const PPSecondariesEnergyDistribution &secondariesEnergyDistribution() {
+	static PPSecondariesEnergyDistribution distribution;
+	return distribution;
+}
+
 void EMPairProduction::performInteraction(Candidate *candidate) const {
 	// scale particle energy instead of background photon energy
 	double z = candidate->getRedshift();
@@ -182,20 +202,19 @@ void EMPairProduction::performInteraction(Candidate *candidate) const {
 		return;
 
 	// check if in tabulated energy range
-	if (E < tabE.front() or (E > tabE.back()))
+	if (E < tables->tabE.front() or (E > tables->tabE.back()))
 		return;
 
 	// sample the value of s
 	Random &random = Random::instance();
-	size_t i = closestIndex(E, tabE);  // find closest tabulation point
-	size_t j = random.randBin(tabCDF[i]);
-	double lo = std::max(4 * mec2 * mec2, tabs[j-1]);  // first s-tabulation point below min(s_kin) = (2 me c^2)^2; ensure physical value
-	double hi = tabs[j];
+	size_t i = closestIndex(E, tables->tabE);  // find closest tabulation point
+	size_t j = tables->sBins.sample(i, random);
+	double lo = std::max(4 * mec2 * mec2, tables->tabs[j-1]);  // first s-tabulation point below min(s_kin) = (2 me c^2)^2; ensure physical value
+	double hi = tables->tabs[j];
 	double s = lo + random.rand() * (hi - lo);
 
 	// sample electron / positron energy
-	static PPSecondariesEnergyDistribution interpolation;
-	double Ee = interpolation.sample(E, s);
+	double Ee = secondariesEnergyDistribution().sample(E, s);
 	double Ep = E - Ee;
 	double f = Ep / E;
 
@@ -217,22 +236,37 @@ void EMPairProduction::performInteraction(Candidate *candidate) const {
 	}
 }
 
-void EMPairProduction::process(Candidate *candidate) const {
+unsigned int EMPairProduction::getParticleClasses() const {
+	return ParticleClassPhoton;
+}
+
+double EMPairProduction::interactionRate(const Candidate *candidate) const {
 	// check if photon
 	if (candidate->current.getId() != 22)
-		return;
+		return 0;
 
 	// scale particle energy instead of background photon energy
 	double z = candidate->getRedshift();
 	double E = candidate->current.getEnergy() * (1 + z);
 
 	// check if in tabulated energy range
-	if ((E < tabEnergy.front()) or (E > tabEnergy.back()))
-		return;
+	if ((E < tables->tabEnergy.front()) or (E > tables->tabEnergy.back()))
+		return 0;
 
 	// interaction rate
-	double rate = interpolate(E, tabEnergy, tabRate);
+	double rate = tables->rate.interpolate(E);
 	rate *= pow_integer<2>(1 + z) * photonField->getRedshiftScaling(z);
+	return rate;
+}
+
+void EMPairProduction::interact(Candidate *candidate) const {
+	performInteraction(candidate);
+}
+
+void EMPairProduction::process(Candidate *candidate) const {
+	double rate = interactionRate(candidate);
+	if (rate <= 0)
+		return;
 
 	// run this loop at least once to limit the step size 
 	double step = candidate->getCurrentStep();
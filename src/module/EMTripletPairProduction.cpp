@@ -1,5 +1,6 @@
 #include "crpropa/module/EMTripletPairProduction.h"
 #include "crpropa/Units.h"
+#include "crpropa/TableRegistry.h"
 #include "crpropa/Random.h"
 
 #include <fstream>
@@ -21,8 +22,12 @@ void EMTripletPairProduction::setPhotonField(ref_ptr<PhotonField> photonField) {
 	this->photonField = photonField;
 	std::string fname = photonField->getFieldName();
 	setDescription("EMTripletPairProduction: " + fname);
-	initRate(getDataPath("EMTripletPairProduction/rate_" + fname + ".txt"));
-	initCumulativeRate(getDataPath("EMTripletPairProduction/cdf_" + fname + ".txt"));
+	if (!TableRegistry::find("EMTripletPairProduction", fname, tables)) {
+		tables = new Tables();
+		initRate(getDataPath("EMTripletPairProduction/rate_" + fname + ".txt"));
+		initCumulativeRate(getDataPath("EMTripletPairProduction/cdf_" + fname + ".txt"));
+		TableRegistry::insert("EMTripletPairProduction", fname, tables);
+	}
 }
 
 void EMTripletPairProduction::setHaveElectrons(bool haveElectrons) {
@@ -43,22 +48,27 @@ void EMTripletPairProduction::initRate(std::string filename) {
 	if (!infile.good())
 		throw std::runtime_error("EMTripletPairProduction: could not open file " + filename);
 
+	TableRegistry::detach(tables);
+
 	// clear previously loaded interaction rates
-	tabEnergy.clear();
-	tabRate.clear();
+	tables->tabEnergy.clear();
+	tables->tabRate.clear();
 
 	while (infile.good()) {
 		if (infile.peek() != '#') {
 			double a, b;
 			infile >> a >> b;
 			if (infile) {
-				tabEnergy.push_back(pow(10, a) * eV);
-				tabRate.push_back(b / Mpc);
+				tables->tabEnergy.push_back(pow(10, a) * eV);
+				tables->tabRate.push_back(b / Mpc);
 			}
 		}
 		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
 	}
 	infile.close();
+
+	if (tables->tabEnergy.size() > 1)
+		tables->rate = UniformLogTable(tables->tabEnergy, tables->tabRate);
 }
 
 void EMTripletPairProduction::initCumulativeRate(std::string filename) {
@@ -68,10 +78,13 @@ void EMTripletPairProduction::initCumulativeRate(std::string filename) {
 		throw std::runtime_error(
 				"EMTripletPairProduction: could not open file " + filename);
 
+	TableRegistry::detach(tables);
+
 	// clear previously loaded tables
-	tabE.clear();
-	tabs.clear();
-	tabCDF.clear();
+	tables->tabE.clear();
+	tables->tabs.clear();
+	tables->tabCDF.clear();
+	tables->sBins = AliasTable();
 	
 	// skip header
 	while (infile.peek() == '#')
@@ -82,7 +95,7 @@ void EMTripletPairProduction::initCumulativeRate(std::string filename) {
 	infile >> a; // skip first value
 	while (infile.good() and (infile.peek() != '\n')) {
 		infile >> a;
-		tabs.push_back(pow(10, a) * eV * eV);
+		tables->tabs.push_back(pow(10, a) * eV * eV);
 	}
 
 	// read all following lines: E, cdf values
@@ -90,13 +103,14 @@ void EMTripletPairProduction::initCumulativeRate(std::string filename) {
 		infile >> a;
 		if (!infile)
 			break;  // end of file
-		tabE.push_back(pow(10, a) * eV);
+		tables->tabE.push_back(pow(10, a) * eV);
 		std::vector<double> cdf;
-		for (int i = 0; i < tabs.size(); i++) {
+		for (int i = 0; i < tables->tabs.size(); i++) {
 			infile >> a;
 			cdf.push_back(a / Mpc);
 		}
-		tabCDF.push_back(cdf);
+		tables->tabCDF.push_back(cdf);
+		tables->sBins.add(cdf);
 	}
 	infile.close();
 }
@@ -110,14 +124,14 @@ void EMTripletPairProduction::performInteraction(Candidate *candidate) const {
 	double z = candidate->getRedshift();
 	double E = candidate->current.getEnergy() * (1 + z);
 
-	if (E < tabE.front() or E > tabE.back())
+	if (E < tables->tabE.front() or E > tables->tabE.back())
 		return;
 
 	// sample the value of eps
 	Random &random = Random::instance();
-	size_t i = closestIndex(E, tabE);
-	size_t j = random.randBin(tabCDF[i]);
-	double s_kin = pow(10, log10(tabs[j]) + (random.rand() - 0.5) * 0.1);
+	size_t i = closestIndex(E, tables->tabE);
+	size_t j = tables->sBins.sample(i, random);
+	double s_kin = pow(10, log10(tables->tabs[j]) + (random.rand() - 0.5) * 0.1);
 	double eps = s_kin / 4. / E; // random background photon energy
 
 	// Use approximation from A. Mastichiadis et al., Astroph. Journ. 300:178-189 (1986), eq. 30.
@@ -144,23 +158,37 @@ void EMTripletPairProduction::performInteraction(Candidate *candidate) const {
 	candidate->current.setEnergy((E - 2 * Epp) / (1. + z));
 }
 
-void EMTripletPairProduction::process(Candidate *candidate) const {
+unsigned int EMTripletPairProduction::getParticleClasses() const {
+	return ParticleClassElectron;
+}
+
+double EMTripletPairProduction::interactionRate(const Candidate *candidate) const {
 	// check if electron / positron
 	int id = candidate->current.getId();
 	if (abs(id) != 11)
-		return;
+		return 0;
 
 	// scale the particle energy instead of background photons
 	double z = candidate->getRedshift();
 	double E = (1 + z) * candidate->current.getEnergy();
 
 	// check if in tabulated energy range
-	if ((E < tabEnergy.front()) or (E > tabEnergy.back()))
-		return;
+	if ((E < tables->tabEnergy.front()) or (E > tables->tabEnergy.back()))
+		return 0;
 
 	// cosmological scaling of interaction distance (comoving)
 	double scaling = pow_integer<2>(1 + z) * photonField->getRedshiftScaling(z);
-	double rate = scaling * interpolate(E, tabEnergy, tabRate);
+	return scaling * tables->rate.interpolate(E);
+}
+
+void EMTripletPairProduction::interact(Candidate *candidate) const {
+	performInteraction(candidate);
+}
+
+void EMTripletPairProduction::process(Candidate *candidate) const {
+	double rate = interactionRate(candidate);
+	if (rate <= 0)
+		return;
 
 	// run this loop at least once to limit the step size
 	double step = candidate->getCurrentStep();
@@ -1,5 +1,6 @@
 #include "crpropa/module/ElasticScattering.h"
 #include "crpropa/Units.h"
+#include "crpropa/TableRegistry.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
 #include "crpropa/Random.h"
@@ -27,8 +28,12 @@ void ElasticScattering::setPhotonField(ref_ptr<PhotonField> photonField) {
 	this->photonField = photonField;
 	std::string fname = photonField->getFieldName();
 	setDescription("ElasticScattering: " + fname);
-	initRate(getDataPath("ElasticScattering/rate_" + fname.substr(0,3) + ".txt"));
-	initCDF(getDataPath("ElasticScattering/cdf_" + fname.substr(0,3) + ".txt"));
+	if (!TableRegistry::find("ElasticScattering", fname, tables)) {
+		tables = new Tables();
+		initRate(getDataPath("ElasticScattering/rate_" + fname.substr(0,3) + ".txt"));
+		initCDF(getDataPath("ElasticScattering/cdf_" + fname.substr(0,3) + ".txt"));
+		TableRegistry::insert("ElasticScattering", fname, tables);
+	}
 }
 
 void ElasticScattering::initRate(std::string filename) {
@@ -36,7 +41,8 @@ void ElasticScattering::initRate(std::string filename) {
 	if (not infile.good())
 		throw std::runtime_error("ElasticScattering: could not open file " + filename);
 
-	tabRate.clear();
+	TableRegistry::detach(tables);
+	tables->tabRate.clear();
 
 	while (infile.good()) {
 		if (infile.peek() == '#') {
@@ -47,7 +53,7 @@ void ElasticScattering::initRate(std::string filename) {
 		infile >> r;
 		if (!infile)
 			break;
-		tabRate.push_back(r / Mpc);
+		tables->tabRate.push_back(r / Mpc);
 	}
 
 	infile.close();
@@ -58,7 +64,8 @@ void ElasticScattering::initCDF(std::string filename) {
 	if (not infile.good())
 		throw std::runtime_error("ElasticScattering: could not open file " + filename);
 
-	tabCDF.clear();
+	TableRegistry::detach(tables);
+	tables->tabCDF.clear();
 	std::string line;
 	double a;
 	while (std::getline(infile, line)) {
@@ -73,52 +80,70 @@ void ElasticScattering::initCDF(std::string filename) {
 			lineStream >> a;
 			cdf[i] = a;
 		}
-		tabCDF.push_back(cdf);
+		tables->tabCDF.push_back(cdf);
 	}
 
 	infile.close();
 }
 
-void ElasticScattering::process(Candidate *candidate) const {
+unsigned int ElasticScattering::getParticleClasses() const {
+	return ParticleClassNucleus;
+}
+
+double ElasticScattering::interactionRate(const Candidate *candidate) const {
 	int id = candidate->current.getId();
 	double z = candidate->getRedshift();
 
 	if (not isNucleus(id))
-		return;
+		return 0;
 
 	double lg = log10(candidate->current.getLorentzFactor() * (1 + z));
 	if ((lg < lgmin) or (lg > lgmax))
-		return;
+		return 0;
 
 	int A = massNumber(id);
 	int Z = chargeNumber(id);
 	int N = A - Z;
 
-	double step = candidate->getCurrentStep();
-	while (step > 0) {
+	double rate = interpolateEquidistant(lg, lgmin, lgmax, tables->tabRate);
+	rate *= Z * N / double(A);  // TRK scaling
+	rate *= pow_integer<2>(1 + z) * photonField->getRedshiftScaling(z);  // cosmological scaling
+	return rate;
+}
+
+void ElasticScattering::interact(Candidate *candidate) const {
+	double z = candidate->getRedshift();
+	double lg = log10(candidate->current.getLorentzFactor() * (1 + z));
+	Random &random = Random::instance();
+
+	// draw random background photon energy from CDF
+	size_t i = floor((lg - lgmin) / (lgmax - lgmin) * (nlg - 1)); // index of closest gamma tabulation point
+	size_t j = random.randBin(tables->tabCDF[i]) - 1; // index of next lower tabulated eps value
+	double binWidth = (epsmax - epsmin) / (neps - 1); // logarithmic bin width
+	double eps = pow(10, epsmin + (j + random.rand()) * binWidth);
+
+	// boost to lab frame
+	double cosTheta = 2 * random.rand() - 1;
+	double E = eps * candidate->current.getLorentzFactor() * (1. - cosTheta);
 
-		double rate = interpolateEquidistant(lg, lgmin, lgmax, tabRate);
-		rate *= Z * N / double(A);  // TRK scaling
-		rate *= pow_integer<2>(1 + z) * photonField->getRedshiftScaling(z);  // cosmological scaling
+	Vector3d pos = random.randomInterpolatedPosition(candidate->previous.getPosition(), candidate->current.getPosition());
+	candidate->addSecondary(22, E, pos);
+}
 
+void ElasticScattering::process(Candidate *candidate) const {
+	double rate = interactionRate(candidate);
+	if (rate <= 0)
+		return;
+
+	Random &random = Random::instance();
+	double step = candidate->getCurrentStep();
+	while (step > 0) {
 		// check for interaction
-		Random &random = Random::instance();
 		double randDist = -log(random.rand()) / rate;
 		if (step < randDist)
 			return;
 
-		// draw random background photon energy from CDF
-		size_t i = floor((lg - lgmin) / (lgmax - lgmin) * (nlg - 1)); // index of closest gamma tabulation point
-		size_t j = random.randBin(tabCDF[i]) - 1; // index of next lower tabulated eps value
-		double binWidth = (epsmax - epsmin) / (neps - 1); // logarithmic bin width
-		double eps = pow(10, epsmin + (j + random.rand()) * binWidth);
-
-		// boost to lab frame
-		double cosTheta = 2 * random.rand() - 1;
-		double E = eps * candidate->current.getLorentzFactor() * (1. - cosTheta);
-
-		Vector3d pos = random.randomInterpolatedPosition(candidate->previous.getPosition(), candidate->current.getPosition());
-		candidate->addSecondary(22, E, pos);
+		interact(candidate);
 
 		// repeat with remaining step
 		step -= randDist;
@@ -1,10 +1,11 @@
 #include "crpropa/module/ElectronPairProduction.h"
 #include "crpropa/Units.h"
+#include "crpropa/TableRegistry.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
 #include "crpropa/Random.h"
 
-#include <fstream>
 #include <limits>
 #include <stdexcept>
 
@@ -15,14 +16,19 @@ ElectronPairProduction::ElectronPairProduction(ref_ptr<PhotonField> photonField,
 	setPhotonField(photonField);
 	this->haveElectrons = haveElectrons;
 	this->limit = limit;
+	this->thinning = 0;
 }
 
 void ElectronPairProduction::setPhotonField(ref_ptr<PhotonField> photonField) {
 	this->photonField = photonField;
 	std::string fname = photonField->getFieldName();
 	setDescription("ElectronPairProduction: " + fname);
-	initRate(getDataPath("ElectronPairProduction/lossrate_" + fname + ".txt"));
-	initSpectrum(getDataPath("ElectronPairProduction/spectrum_" + fname.substr(0,3) + ".txt"));
+	if (!TableRegistry::find("ElectronPairProduction", fname, tables)) {
+		tables = new Tables();
+		initRate(getDataPath("ElectronPairProduction/lossrate_" + fname + ".txt"));
+		initSpectrum(getDataPath("ElectronPairProduction/spectrum_" + fname.substr(0,3) + ".txt"));
+		TableRegistry::insert("ElectronPairProduction", fname, tables);
+	}
 }
 
 void ElectronPairProduction::setHaveElectrons(bool haveElectrons) {
@@ -33,48 +39,52 @@ void ElectronPairProduction::setLimit(double limit) {
 	this->limit = limit;
 }
 
-void ElectronPairProduction::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
+void ElectronPairProduction::setThinning(double thinning) {
+	this->thinning = thinning;
+}
 
-	if (!infile.good())
+void ElectronPairProduction::initRate(std::string filename) {
+	DataTable table(filename);
+	if (!table.good())
 		throw std::runtime_error("ElectronPairProduction: could not open file " + filename);
 
+	TableRegistry::detach(tables);
+
 	// clear previously loaded interaction rates
-	tabLorentzFactor.clear();
-	tabLossRate.clear();
-
-	while (infile.good()) {
-		if (infile.peek() != '#') {
-			double a, b;
-			infile >> a >> b;
-			if (infile) {
-				tabLorentzFactor.push_back(pow(10, a));
-				tabLossRate.push_back(b / Mpc);
-			}
-		}
-		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
+	tables->tabLorentzFactor.clear();
+	tables->tabLossRate.clear();
+
+	// rows: log10(Lorentz factor), energy loss rate
+	for (size_t i = 0; i < table.rows(); i++) {
+		if (table.columns(i) < 2)
+			continue;
+		tables->tabLorentzFactor.push_back(pow(10, table.get(i, 0)));
+		tables->tabLossRate.push_back(table.get(i, 1) / Mpc);
 	}
-	infile.close();
+
+	if (tables->tabLorentzFactor.size() > 1)
+		tables->lossRate = UniformLogTable(tables->tabLorentzFactor, tables->tabLossRate);
 }
 
 void ElectronPairProduction::initSpectrum(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (!infile.good())
+	DataTable table(filename);
+	if (!table.good())
 		throw std::runtime_error("ElectronPairProduction: could not open file " + filename);
+	if (table.size() < 70 * 170)
+		throw std::runtime_error("ElectronPairProduction: incomplete spectrum in " + filename);
 
-	double dNdE;
-	tabSpectrum.resize(70);
+	const double *dNdE = table.data();
+	TableRegistry::detach(tables);
+	tables->tabSpectrum.resize(70);
 	for (size_t i = 0; i < 70; i++) {
-		tabSpectrum[i].resize(170);
+		tables->tabSpectrum[i].resize(170);
 		for (size_t j = 0; j < 170; j++) {
-			infile >> dNdE;
-			tabSpectrum[i][j] = dNdE * pow(10, (7 + 0.1 * j)); // read electron distribution pdf(Ee) ~ dN/dEe * Ee
+			tables->tabSpectrum[i][j] = dNdE[i * 170 + j] * pow(10, (7 + 0.1 * j)); // read electron distribution pdf(Ee) ~ dN/dEe * Ee
 		}
 		for (size_t j = 1; j < 170; j++) {
-			tabSpectrum[i][j] += tabSpectrum[i][j - 1]; // cdf(Ee), unnormalized
+			tables->tabSpectrum[i][j] += tables->tabSpectrum[i][j - 1]; // cdf(Ee), unnormalized
 		}
 	}
-	infile.close();
 }
 
 double ElectronPairProduction::lossLength(int id, double lf, double z) const {
@@ -83,20 +93,24 @@ double ElectronPairProduction::lossLength(int id, double lf, double z) const {
 		return std::numeric_limits<double>::max(); // no pair production on uncharged particles
 
 	lf *= (1 + z);
-	if (lf < tabLorentzFactor.front())
+	if (lf < tables->tabLorentzFactor.front())
 		return std::numeric_limits<double>::max(); // below energy threshold
 
 	double rate;
-	if (lf < tabLorentzFactor.back())
-		rate = interpolate(lf, tabLorentzFactor, tabLossRate); // interpolation
+	if (lf < tables->tabLorentzFactor.back())
+		rate = tables->lossRate.interpolate(lf); // interpolation
 	else
-		rate = tabLossRate.back() * pow(lf / tabLorentzFactor.back(), -0.6); // extrapolation
+		rate = tables->tabLossRate.back() * pow(lf / tables->tabLorentzFactor.back(), -0.6); // extrapolation
 
 	double A = nuclearMass(id) / mass_proton; // more accurate than massNumber(Id)
 	rate *= Z * Z / A * pow_integer<3>(1 + z) * photonField->getRedshiftScaling(z);
 	return 1. / rate;
 }
 
+unsigned int ElectronPairProduction::getParticleClasses() const {
+	return ParticleClassNucleus;
+}
+
 void ElectronPairProduction::process(Candidate *c) const {
 	int id = c->current.getId();
 	if (not (isNucleus(id)))
@@ -113,13 +127,15 @@ void ElectronPairProduction::process(Candidate *c) const {
 
 	if (haveElectrons) {
 		double dE = c->current.getEnergy() * loss;  // energy loss
+		double dEtotal = dE;
+		double w0 = c->getWeight();
 		int i = round((log10(lf) - 6.05) * 10);  // find closest cdf(Ee|log10(gamma))
 		i = std::min(std::max(i, 0), 69);
 		Random &random = Random::instance();
 
 		// draw pairs as long as their energy is smaller than the pair production energy loss
 		while (dE > 0) {
-			size_t j = random.randBin(tabSpectrum[i]);
+			size_t j = random.randBin(tables->tabSpectrum[i]);
 			double Ee = pow(10, 6.95 + (j + random.rand()) * 0.1) * eV;
 			double Epair = 2 * Ee; // NOTE: electron and positron in general don't have same lab frame energy, but averaged over many draws the result is consistent
 			// if the remaining energy is not sufficient check for random accepting
@@ -129,9 +145,19 @@ void ElectronPairProduction::process(Candidate *c) const {
 
 			// create pair and repeat with remaining energy
 			dE -= Epair;
+
+			// thinning: keep the pair with probability (Epair / dEtotal)^thinning
+			double w = w0;
+			if (thinning > 0) {
+				double p = pow(std::min(Epair / dEtotal, 1.), thinning);
+				if (random.rand() > p)
+					continue;
+				w /= p;
+			}
+
 			Vector3d pos = random.randomInterpolatedPosition(c->previous.getPosition(), c->current.getPosition());
-			c->addSecondary( 11, Ee, pos);
-			c->addSecondary(-11, Ee, pos);
+			c->addSecondary( 11, Ee, pos, w);
+			c->addSecondary(-11, Ee, pos, w);
 		}
 	}
 
@@ -300,9 +300,9 @@ void HDF5Output::process(Candidate* candidate) const {
 			iter != properties.end(); ++iter)
 	{
 		  Variant v;
-			if (candidate->hasProperty((*iter).name))
+			if (candidate->hasProperty((*iter).key))
 			{
-				v = candidate->getProperty((*iter).name);
+				v = candidate->getProperty((*iter).key);
 			}
 			else
 			{
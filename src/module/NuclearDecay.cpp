@@ -1,10 +1,10 @@
 #include "crpropa/module/NuclearDecay.h"
 #include "crpropa/Units.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
 #include "crpropa/Random.h"
 
-#include <fstream>
 #include <limits>
 #include <cmath>
 #include <stdexcept>
@@ -18,38 +18,42 @@ NuclearDecay::NuclearDecay(bool electrons, bool photons, bool neutrinos, double
 	havePhotons = photons;
 	haveNeutrinos = neutrinos;
 	limit = l;
+	instantDecay = 0;
 	setDescription("NuclearDecay");
 
 	// load decay table
 	std::string filename = getDataPath("nuclear_decay.txt");
-	std::ifstream infile(filename.c_str());
-	if (!infile.good())
+	DataTable table(filename);
+	if (!table.good())
 		throw std::runtime_error(
 				"crpropa::NuclearDecay: could not open file " + filename);
 
+	// rows: Z, N, channel, lifetime, pairs of gamma energy and intensity
 	decayTable.resize(27 * 31);
-	std::string line;
-	while (std::getline(infile,line)) {
-		std::stringstream stream(line);
-		if (stream.peek() == '#')
-			continue;
+	for (size_t i = 0; i < table.rows(); i++) {
+		size_t n = table.columns(i);
+		if (n < 4)
+			throw std::runtime_error(
+					"crpropa::NuclearDecay: incomplete row in " + filename);
+		const double *row = table.row(i);
 		DecayMode decay;
-		int Z, N;
-		double lifetime;
-		stream >> Z >> N >> decay.channel >> lifetime;
+		int Z = row[0];
+		int N = row[1];
+		decay.channel = row[2];
+		double lifetime = row[3];
 		decay.rate = 1. / lifetime / c_light; // decay rate in [1/m]
-		std::vector<double> gamma;
-		double val;
-		while (stream >> val)
-			gamma.push_back(val);
-		for (int i = 0; i < gamma.size(); i += 2) {
-			decay.energy.push_back(gamma[i] * keV);
-			decay.intensity.push_back(gamma[i+1]);
+		for (size_t j = 4; j + 1 < n; j += 2) {
+			decay.energy.push_back(row[j] * keV);
+			decay.intensity.push_back(row[j + 1]);
 		}
-		if (infile)
-			decayTable[Z * 31 + N].push_back(decay);
+		decayTable[Z * 31 + N].push_back(decay);
 	}
-	infile.close();
+
+	// total decay rate of each isotope
+	decayRate.resize(27 * 31, 0.);
+	for (size_t i = 0; i < decayTable.size(); i++)
+		for (size_t j = 0; j < decayTable[i].size(); j++)
+			decayRate[i] += decayTable[i][j].rate;
 }
 
 void NuclearDecay::setHaveElectrons(bool b) {
@@ -68,6 +72,49 @@ void NuclearDecay::setLimit(double l) {
 	limit = l;
 }
 
+void NuclearDecay::setInstantDecay(double fraction) {
+	instantDecay = fraction;
+}
+
+double NuclearDecay::getInstantDecay() const {
+	return instantDecay;
+}
+
+unsigned int NuclearDecay::getParticleClasses() const {
+	return ParticleClassNucleus;
+}
+
+double NuclearDecay::interactionRate(const Candidate *candidate) const {
+	int id = candidate->current.getId();
+	if (not (isNucleus(id)))
+		return 0;
+
+	int A = massNumber(id);
+	int Z = chargeNumber(id);
+	if ((Z > 26) or (A - Z > 30))
+		return 0;
+	double rate = decayRate[Z * 31 + A - Z];
+	rate /= candidate->current.getLorentzFactor();  // relativistic time dilation
+	rate /= (1 + candidate->getRedshift());  // rate per light travel distance -> rate per comoving distance
+	return rate;
+}
+
+void NuclearDecay::interact(Candidate *candidate) const {
+	int id = candidate->current.getId();
+	int A = massNumber(id);
+	int Z = chargeNumber(id);
+	const std::vector<DecayMode> &decays = decayTable[Z * 31 + A - Z];
+
+	// select the decay mode by its share of the total rate
+	double cmp = Random::instance().rand() * decayRate[Z * 31 + A - Z];
+	size_t i = 0;
+	while ((i + 1 < decays.size()) and (cmp > decays[i].rate)) {
+		cmp -= decays[i].rate;
+		i++;
+	}
+	performInteraction(candidate, decays[i].channel);
+}
+
 void NuclearDecay::process(Candidate *candidate) const {
 	// the loop should be processed at least once for limiting the next step
 	double step = candidate->getCurrentStep();
@@ -87,6 +134,13 @@ void NuclearDecay::process(Candidate *candidate) const {
 		if (decays.size() == 0)
 			return;
 
+		// decay at once if much shorter-lived than the step
+		double gamma = candidate->current.getLorentzFactor();
+		if (decayRate[Z * 31 + N] / gamma / (1 + z) * instantDecay * step > 1) {
+			interact(candidate);
+			continue;
+		}
+
 		// find interaction mode with minimum random decay distance
 		Random &random = Random::instance();
 		double randDistance = std::numeric_limits<double>::max();
@@ -335,8 +335,7 @@ DetectionState ObserverTimeEvolution::checkDetection(Candidate *c) const {
 	if (detList.size()) {
 		double length = c->getTrajectoryLength();
 		size_t index;
-		const std::string DI = "DetectionIndex";
-		std::string value;
+		static const PropertyKey DI("DetectionIndex");
 
 		// Load the last detection index
 		if (c->hasProperty(DI)) {
@@ -127,6 +127,7 @@ void Output::enableProperty(const std::string &property, const Variant &defaultV
 	modify();
 	Property prop;
 	prop.name = property;
+	prop.key = PropertyKey(property);
 	prop.comment = comment;
 	prop.defaultValue = defaultValue;
 	properties.push_back(prop);
@@ -1,14 +1,15 @@
 #include "crpropa/module/PhotoDisintegration.h"
 #include "crpropa/Units.h"
+#include "crpropa/TableRegistry.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
 #include "crpropa/Random.h"
 #include "kiss/logger.h"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
-#include <sstream>
-#include <fstream>
 #include <stdexcept>
 
 namespace crpropa {
@@ -17,6 +18,21 @@ const double PhotoDisintegration::lgmin = 6;  // minimum log10(Lorentz-factor)
 const double PhotoDisintegration::lgmax = 14; // maximum log10(Lorentz-factor)
 const size_t PhotoDisintegration::nlg = 201;  // number of Lorentz-factor steps
 
+PhotoDisintegration::Isotope::Isotope() :
+		rate(npos), branch(0), nBranch(0) {
+}
+
+// linear interpolation of the nlg values Y tabulated equidistantly in [lgmin, lgmax]
+double PhotoDisintegration::interpolateTable(double lg, const double *Y) {
+	double p = (lg - lgmin) / (lgmax - lgmin) * (nlg - 1);
+	if (p <= 0)
+		return Y[0];
+	if (p >= nlg - 1)
+		return Y[nlg - 1];
+	size_t i = p;
+	return Y[i] + (p - i) * (Y[i + 1] - Y[i]);
+}
+
 PhotoDisintegration::PhotoDisintegration(ref_ptr<PhotonField> f, bool havePhotons, double limit) {
 	setPhotonField(f);
 	this->havePhotons = havePhotons;
@@ -27,9 +43,13 @@ void PhotoDisintegration::setPhotonField(ref_ptr<PhotonField> photonField) {
 	this->photonField = photonField;
 	std::string fname = photonField->getFieldName();
 	setDescription("PhotoDisintegration: " + fname);
-	initRate(getDataPath("Photodisintegration/rate_" + fname + ".txt"));
-	initBranching(getDataPath("Photodisintegration/branching_" + fname + ".txt"));
-	initPhotonEmission(getDataPath("Photodisintegration/photon_emission_" + fname.substr(0,3) + ".txt"));
+	if (!TableRegistry::find("PhotoDisintegration", fname, tables)) {
+		tables = new Tables();
+		initRate(getDataPath("Photodisintegration/rate_" + fname + ".txt"));
+		initBranching(getDataPath("Photodisintegration/branching_" + fname + ".txt"));
+		initPhotonEmission(getDataPath("Photodisintegration/photon_emission_" + fname.substr(0,3) + ".txt"));
+		TableRegistry::insert("PhotoDisintegration", fname, tables);
+	}
 }
 
 void PhotoDisintegration::setHavePhotons(bool havePhotons) {
@@ -41,139 +61,168 @@ void PhotoDisintegration::setLimit(double limit) {
 }
 
 void PhotoDisintegration::initRate(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (not infile.good())
+	DataTable table(filename);
+	if (not table.good())
 		throw std::runtime_error("PhotoDisintegration: could not open file " + filename);
 
+	TableRegistry::detach(tables);
+
 	// clear previously loaded interaction rates
-	pdRate.clear();
-	pdRate.resize(27 * 31);
+	tables->pdRate.clear();
+	tables->isotopes.resize(27 * 31);
+	for (size_t i = 0; i < tables->isotopes.size(); i++)
+		tables->isotopes[i].rate = Isotope::npos;
+
+	// rows: Z, N, rate for each Lorentz factor
+	for (size_t i = 0; i < table.rows(); i++) {
+		if (table.columns(i) < 2 + nlg)
+			throw std::runtime_error("PhotoDisintegration: incomplete row in " + filename);
+		const double *row = table.row(i);
+		int Z = row[0];
+		int N = row[1];
+		tables->isotopes[Z * 31 + N].rate = tables->pdRate.size();
+		for (size_t j = 0; j < nlg; j++)
+			tables->pdRate.push_back(row[2 + j] / Mpc);
+	}
+}
 
-	std::string line;
-	while (std::getline(infile, line)) {
-		if (line[0] == '#')
-			continue;
-		std::stringstream lineStream(line);
+void PhotoDisintegration::initBranching(std::string filename) {
+	DataTable table(filename);
+	if (not table.good())
+		throw std::runtime_error("PhotoDisintegration: could not open file " + filename);
 
-		int Z, N;
-		lineStream >> Z;
-		lineStream >> N;
+	TableRegistry::detach(tables);
+
+	// rows: Z, N, channel, branching ratio for each Lorentz factor
+	std::vector<std::vector<size_t> > isotopeRows(27 * 31);
+	for (size_t i = 0; i < table.rows(); i++) {
+		if (table.columns(i) < 3 + nlg)
+			throw std::runtime_error("PhotoDisintegration: incomplete row in " + filename);
+		int Z = table.get(i, 0);
+		int N = table.get(i, 1);
+		isotopeRows[Z * 31 + N].push_back(i);
+	}
 
-		double r;
-		for (size_t i = 0; i < nlg; i++) {
-			lineStream >> r;
-			pdRate[Z * 31 + N].push_back(r / Mpc);
+	// clear previously loaded branching ratios
+	tables->pdChannel.clear();
+	tables->pdBranch.clear();
+	tables->isotopes.resize(27 * 31);
+
+	// channels of each isotope and the cumulative branching ratios for each
+	// Lorentz factor, so that the branching ratios of isotope i start at
+	// pdBranch[isotopes[i].branch * nlg]
+	for (size_t idx = 0; idx < isotopeRows.size(); idx++) {
+		const std::vector<size_t> &rows = isotopeRows[idx];
+		Isotope &isotope = tables->isotopes[idx];
+		isotope.branch = tables->pdChannel.size();
+		isotope.nBranch = rows.size();
+		for (size_t k = 0; k < rows.size(); k++)
+			tables->pdChannel.push_back(table.get(rows[k], 2));
+		for (size_t l = 0; l < nlg; l++) {
+			double sum = 0;
+			for (size_t k = 0; k < rows.size(); k++) {
+				sum += table.get(rows[k], 3 + l);
+				tables->pdBranch.push_back(sum);
+			}
 		}
 	}
-	infile.close();
 }
 
-void PhotoDisintegration::initBranching(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (not infile.good())
+void PhotoDisintegration::initPhotonEmission(std::string filename) {
+	DataTable table(filename);
+	if (not table.good())
 		throw std::runtime_error("PhotoDisintegration: could not open file " + filename);
 
-	// clear previously loaded interaction rates
-	pdBranch.clear();
-	pdBranch.resize(27 * 31);
-
-	std::string line;
-	while (std::getline(infile, line)) {
-		if (line[0] == '#')
-			continue;
-
-		std::stringstream lineStream(line);
+	TableRegistry::detach(tables);
 
-		int Z, N;
-		lineStream >> Z;
-		lineStream >> N;
+	// clear previously loaded emission probabilities
+	tables->pdPhoton.clear();
+
+	// rows: Z, N, Zd, Nd, photon energy, probability for each Lorentz factor
+	for (size_t i = 0; i < table.rows(); i++) {
+		if (table.columns(i) < 5 + nlg)
+			throw std::runtime_error("PhotoDisintegration: incomplete row in " + filename);
+		const double *row = table.row(i);
+		int Z = row[0];
+		int N = row[1];
+		int Zd = row[2];
+		int Nd = row[3];
 
-		Branch branch;
-		lineStream >> branch.channel;
+		PhotonEmission em;
+		em.energy = row[4] * eV;
+		em.emissionProbability.assign(row + 5, row + 5 + nlg);
 
-		double r;
-		for (size_t i = 0; i < nlg; i++) {
-			lineStream >> r;
-			branch.branchingRatio.push_back(r);
+		int key = Z * 1000000 + N * 10000 + Zd * 100 + Nd;
+		if (tables->pdPhoton.find(key) == tables->pdPhoton.end()) {
+			std::vector<PhotonEmission> emissions;
+			tables->pdPhoton[key] = emissions;
 		}
-
-		pdBranch[Z * 31 + N].push_back(branch);
+		tables->pdPhoton[key].push_back(em);
 	}
+}
 
-	infile.close();
+unsigned int PhotoDisintegration::getParticleClasses() const {
+	return ParticleClassNucleus;
 }
 
-void PhotoDisintegration::initPhotonEmission(std::string filename) {
-	std::ifstream infile(filename.c_str());
-	if (not infile.good())
-		throw std::runtime_error("PhotoDisintegration: could not open file " + filename);
+const PhotoDisintegration::Isotope *PhotoDisintegration::findIsotope(int id) const {
+	if (not isNucleus(id))
+		return 0;
 
-	// clear previously loaded emission probabilities
-	pdPhoton.clear();
+	int A = massNumber(id);
+	int Z = chargeNumber(id);
+	int N = A - Z;
 
-	std::string line;
-	while (std::getline(infile, line)) {
-		if (line[0] == '#')
-			continue;
+	// check if disintegration data available
+	if ((Z > 26) or (N > 30))
+		return 0;
+	const Isotope &isotope = tables->isotopes[Z * 31 + N];
+	if (isotope.rate == Isotope::npos)
+		return 0;
+	return &isotope;
+}
 
-		std::stringstream lineStream(line);
+double PhotoDisintegration::interactionRate(const Candidate *candidate) const {
+	const Isotope *isotope = findIsotope(candidate->current.getId());
+	if (isotope == 0)
+		return 0;
 
-		int Z, N, Zd, Nd;
-		lineStream >> Z;
-		lineStream >> N;
-		lineStream >> Zd;
-		lineStream >> Nd;
+	// check if in tabulated energy range
+	double z = candidate->getRedshift();
+	double lg = log10(candidate->current.getLorentzFactor() * (1 + z));
+	if ((lg <= lgmin) or (lg >= lgmax))
+		return 0;
 
-		PhotonEmission em;
-		lineStream >> em.energy;
-		em.energy *= eV;
+	double rate = interpolateTable(lg, &tables->pdRate[isotope->rate]);
+	return rate * pow_integer<2>(1 + z) * photonField->getRedshiftScaling(z); // cosmological scaling, rate per comoving distance
+}
 
-		double r;
-		for (size_t i = 0; i < nlg; i++) {
-			lineStream >> r;
-			em.emissionProbability.push_back(r);
-		}
+void PhotoDisintegration::interact(Candidate *candidate) const {
+	const Isotope *isotope = findIsotope(candidate->current.getId());
+	if ((isotope == 0) or (isotope->nBranch == 0))
+		return;
 
-		int key = Z * 1000000 + N * 10000 + Zd * 100 + Nd;
-		if (pdPhoton.find(key) == pdPhoton.end()) {
-			std::vector<PhotonEmission> emissions;
-			pdPhoton[key] = emissions;
-		}
-		pdPhoton[key].push_back(em);
+	// select channel by the cumulative branching ratios at the closest tabulation point
+	size_t k = 0;
+	if (isotope->nBranch > 1) {
+		double lg = log10(candidate->current.getLorentzFactor() * (1 + candidate->getRedshift()));
+		int l = round((lg - lgmin) / (lgmax - lgmin) * (nlg - 1)); // index of closest tabulation point
+		const double *cdf = &tables->pdBranch[isotope->branch * nlg + l * isotope->nBranch];
+		double cmp = Random::instance().rand();
+		k = std::lower_bound(cdf, cdf + isotope->nBranch, cmp) - cdf;
+		k = std::min(k, isotope->nBranch - 1); // branching ratios may not add up to 1 exactly
 	}
-
-	infile.close();
+	performInteraction(candidate, tables->pdChannel[isotope->branch + k]);
 }
 
 void PhotoDisintegration::process(Candidate *candidate) const {
 	// execute the loop at least once for limiting the next step
 	double step = candidate->getCurrentStep();
 	do {
-		// check if nucleus
-		int id = candidate->current.getId();
-		if (not isNucleus(id))
-			return;
-
-		int A = massNumber(id);
-		int Z = chargeNumber(id);
-		int N = A - Z;
-		size_t idx = Z * 31 + N;
-
-		// check if disintegration data available
-		if ((Z > 26) or (N > 30))
-			return;
-		if (pdRate[idx].size() == 0)
-			return;
-
-		// check if in tabulated energy range
-		double z = candidate->getRedshift();
-		double lg = log10(candidate->current.getLorentzFactor() * (1 + z));
-		if ((lg <= lgmin) or (lg >= lgmax))
+		double rate = interactionRate(candidate);
+		if (rate <= 0)
 			return;
 
-		double rate = interpolateEquidistant(lg, lgmin, lgmax, pdRate[idx]);
-		rate *= pow_integer<2>(1 + z) * photonField->getRedshiftScaling(z); // cosmological scaling, rate per comoving distance
-
 		// check if interaction occurs in this step
 		// otherwise limit next step to a fraction of the mean free path
 		Random &random = Random::instance();
@@ -184,15 +233,7 @@ void PhotoDisintegration::process(Candidate *candidate) const {
 		}
 
 		// select channel and interact
-		const std::vector<Branch> &branches = pdBranch[idx];
-		double cmp = random.rand();
-		int l = round((lg - lgmin) / (lgmax - lgmin) * (nlg - 1)); // index of closest tabulation point
-		size_t i = 0;
-		while ((i < branches.size()) and (cmp > 0)) {
-			cmp -= branches[i].branchingRatio[l];
-			i++;
-		}
-		performInteraction(candidate, branches[i-1].channel);
+		interact(candidate);
 
 		// repeat with remaining step
 		step -= randDist;
@@ -258,34 +299,29 @@ void PhotoDisintegration::performInteraction(Candidate *candidate, int channel)
 	int l = round((lg - lgmin) / (lgmax - lgmin) * (nlg - 1));  // index of closest tabulation point
 	int key = Z*1e6 + (A-Z)*1e4 + (Z+dZ)*1e2 + (A+dA) - (Z+dZ);
 
-	for (int i = 0; i < pdPhoton[key].size(); i++) {
+	std::map<int, std::vector<PhotonEmission> >::const_iterator it = tables->pdPhoton.find(key);
+	if (it == tables->pdPhoton.end())
+		return;
+	const std::vector<PhotonEmission> &emissions = it->second;
+
+	for (int i = 0; i < emissions.size(); i++) {
 		// check for random emission
-		if (random.rand() > pdPhoton[key][i].emissionProbability[l])
+		if (random.rand() > emissions[i].emissionProbability[l])
 			continue;
 
 		// boost to lab frame
 		double cosTheta = 2 * random.rand() - 1;
-		double E = pdPhoton[key][i].energy * lf * (1 - cosTheta);
+		double E = emissions[i].energy * lf * (1 - cosTheta);
 		candidate->addSecondary(22, E, pos);
 	}
 }
 
 double PhotoDisintegration::lossLength(int id, double gamma, double z) {
-	// check if nucleus
-	if (not (isNucleus(id)))
-		return std::numeric_limits<double>::max();
-
-	int A = massNumber(id);
-	int Z = chargeNumber(id);
-	int N = A - Z;
-	size_t idx = Z * 31 + N;
-
 	// check if disintegration data available
-	if ((Z > 26) or (N > 30))
-		return std::numeric_limits<double>::max();
-	const std::vector<double> &rate = pdRate[idx];
-	if (rate.size() == 0)
+	const Isotope *isotope = findIsotope(id);
+	if (isotope == 0)
 		return std::numeric_limits<double>::max();
+	int A = massNumber(id);
 
 	// check if in tabulated energy range
 	double lg = log10(gamma * (1 + z));
@@ -293,16 +329,20 @@ double PhotoDisintegration::lossLength(int id, double gamma, double z) {
 		return std::numeric_limits<double>::max();
 
 	// total interaction rate
-	double lossRate = interpolateEquidistant(lg, lgmin, lgmax, rate);
+	double lossRate = interpolateTable(lg, &tables->pdRate[isotope->rate]);
 
 	// comological scaling, rate per physical distance
 	lossRate *= pow_integer<3>(1 + z) * photonField->getRedshiftScaling(z);
 
 	// average number of nucleons lost for all disintegration channels
+	double p = (lg - lgmin) / (lgmax - lgmin) * (nlg - 1);
+	size_t l = std::min(size_t(p), nlg - 2);
+	double f = p - l;
+	size_t nb = isotope->nBranch;
+	const double *cdf = &tables->pdBranch[isotope->branch * nlg + l * nb];
 	double avg_dA = 0;
-	const std::vector<Branch> &branches = pdBranch[idx];
-	for (size_t i = 0; i < branches.size(); i++) {
-		int channel = branches[i].channel;
+	for (size_t k = 0; k < nb; k++) {
+		int channel = tables->pdChannel[isotope->branch + k];
 		int dA = 0;
 		dA += 1 * digit(channel, 100000);
 		dA += 1 * digit(channel, 10000);
@@ -311,8 +351,10 @@ double PhotoDisintegration::lossLength(int id, double gamma, double z) {
 		dA += 3 * digit(channel, 10);
 		dA += 4 * digit(channel, 1);
 
-		double br = interpolateEquidistant(lg, lgmin, lgmax, branches[i].branchingRatio);
-		avg_dA += br * dA;
+		// branching ratios at the enclosing tabulation points
+		double br0 = cdf[k] - ((k > 0) ? cdf[k - 1] : 0);
+		double br1 = cdf[nb + k] - ((k > 0) ? cdf[nb + k - 1] : 0);
+		avg_dA += ((1 - f) * br0 + f * br1) * dA;
 	}
 
 	lossRate *= avg_dA / A;
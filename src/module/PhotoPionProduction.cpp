@@ -1,5 +1,7 @@
 #include "crpropa/module/PhotoPionProduction.h"
 #include "crpropa/Units.h"
+#include "crpropa/TableRegistry.h"
+#include "crpropa/DataTable.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/Random.h"
 
@@ -10,11 +12,72 @@
 #include <limits>
 #include <cmath>
 #include <sstream>
-#include <fstream>
 #include <stdexcept>
 
 namespace crpropa {
 
+// range of the event library in log10(E_in * eps / GeV^2), from SOPHIA's
+// threshold s = 1.1646 GeV^2 for head-on collisions with protons (slightly
+// above the one of neutrons) to the highest energies of the photon fields
+static const double libraryMin = log10((1.1646 - pow(mass_proton * c_squared / GeV, 2)) / 4);
+static const double libraryMax = 6.5;
+// nucleon energy for generating the library events [GeV]
+static const double libraryEnergy = 1e10;
+
+PhotoPionEventLibrary::PhotoPionEventLibrary(size_t eventsPerBin, size_t binsPerDecade) :
+		eventsPerBin(eventsPerBin), binsPerDecade(binsPerDecade) {
+	if ((eventsPerBin == 0) or (binsPerDecade == 0))
+		throw std::runtime_error("PhotoPionEventLibrary: need at least one event and bin");
+	nBins = (libraryMax - libraryMin) * binsPerDecade + 0.5;
+	offsets.reserve(2 * nBins * eventsPerBin + 1);
+	offsets.push_back(0);
+
+	// SOPHIA - output:
+	double outputEnergy[5][2000];  // [GeV/c, GeV/c, GeV/c, GeV, GeV/c^2]
+	int outPartID[2000];
+	int nParticles;
+
+	Random &random = Random::instance();
+#pragma omp critical(SOPHIA)
+	for (int nature = 0; nature < 2; nature++) {  // 0=proton, 1=neutron
+		for (size_t bin = 0; bin < nBins; bin++) {
+			for (size_t k = 0; k < eventsPerBin; k++) {
+				// events are spread uniformly in log over the bin
+				double lp = libraryMin + (bin + random.rand()) / binsPerDecade;
+				double Ein = libraryEnergy;
+				double eps = pow(10, lp) / Ein;
+				sophiaevent_(nature, Ein, eps, outputEnergy, outPartID, nParticles);
+				for (int i = 0; i < nParticles; i++) {
+					id.push_back(outPartID[i]);
+					fraction.push_back(outputEnergy[3][i] / Ein);
+				}
+				offsets.push_back(id.size());
+			}
+		}
+	}
+}
+
+bool PhotoPionEventLibrary::sample(bool onProton, double Ein, double eps,
+		Random &random, size_t &first, size_t &last) const {
+	double p = (log10(Ein / GeV * eps / GeV) - libraryMin) * binsPerDecade;
+	if (not (p >= 0) or (p >= nBins))
+		return false;
+	size_t bin = p + (onProton ? 0 : nBins);
+	size_t k = std::min(size_t(random.rand53() * eventsPerBin), eventsPerBin - 1);
+	size_t event = bin * eventsPerBin + k;
+	first = offsets[event];
+	last = offsets[event + 1];
+	return true;
+}
+
+size_t PhotoPionEventLibrary::getEventsPerBin() const {
+	return eventsPerBin;
+}
+
+size_t PhotoPionEventLibrary::getBinsPerDecade() const {
+	return binsPerDecade;
+}
+
 PhotoPionProduction::PhotoPionProduction(ref_ptr<PhotonField> field, bool photons, bool neutrinos, bool electrons, bool antiNucleons, double l, bool redshift) {
 	havePhotons = photons;
 	haveNeutrinos = neutrinos;
@@ -38,13 +101,21 @@ void PhotoPionProduction::setPhotonField(ref_ptr<PhotonField> field) {
 	}
 	std::string fname = photonField->getFieldName();
 	setDescription("PhotoPionProduction: " + fname);
-	if (haveRedshiftDependence)
-		initRate(getDataPath("PhotoPionProduction/rate_" + fname.replace(0, 3, "IRBz") + ".txt"));
-	else
-		initRate(getDataPath("PhotoPionProduction/rate_" + fname + ".txt"));
+	std::string kind = haveRedshiftDependence ? "PhotoPionProduction_z" : "PhotoPionProduction";
+	if (!TableRegistry::find(kind, fname, tables)) {
+		tables = new Tables();
+		if (haveRedshiftDependence)
+			initRate(getDataPath("PhotoPionProduction/rate_IRBz" + fname.substr(3) + ".txt"));
+		else
+			initRate(getDataPath("PhotoPionProduction/rate_" + fname + ".txt"));
+		TableRegistry::insert(kind, fname, tables);
+	}
 
 	int background = (fname == "CMB") ? 1 : 2; // photon background: 1 for CMB, 2 for Kneiske IRB
+	bool tabulated = photonFieldSampling.hasTable();
 	this->photonFieldSampling = PhotonFieldSampling(background);
+	if (tabulated)
+		setTabulatedPhotonSampling(true);
 }
 
 void PhotoPionProduction::setHavePhotons(bool b) {
@@ -72,71 +143,106 @@ void PhotoPionProduction::setLimit(double l) {
 	limit = l;
 }
 
+void PhotoPionProduction::setEventLibrary(bool use, size_t eventsPerBin) {
+	if (not use) {
+		eventLibrary = 0;
+		return;
+	}
+	if (eventLibrary and (eventLibrary->getEventsPerBin() == eventsPerBin))
+		return;
+	std::string key = kiss::str(eventsPerBin);
+	if (!TableRegistry::find("PhotoPionEventLibrary", key, eventLibrary)) {
+		eventLibrary = new PhotoPionEventLibrary(eventsPerBin);
+		TableRegistry::insert("PhotoPionEventLibrary", key, eventLibrary);
+	}
+}
+
+bool PhotoPionProduction::getEventLibrary() const {
+	return eventLibrary.valid();
+}
+
+void PhotoPionProduction::setTabulatedPhotonSampling(bool use) {
+	if (not use) {
+		photonFieldSampling.setTable(0);
+		return;
+	}
+	if (photonFieldSampling.hasTable())
+		return;
+	std::string key = (photonField->getFieldName() == "CMB") ? "CMB" : "IRB";
+	ref_ptr<PhotonFieldSampling::Table> table;
+	if (!TableRegistry::find("PhotonFieldSampling", key, table)) {
+		photonFieldSampling.initTable();
+		table = photonFieldSampling.getTable();
+		TableRegistry::insert("PhotonFieldSampling", key, table);
+	}
+	photonFieldSampling.setTable(table);
+}
+
+bool PhotoPionProduction::getTabulatedPhotonSampling() const {
+	return photonFieldSampling.hasTable();
+}
+
 void PhotoPionProduction::initRate(std::string filename) {
+	TableRegistry::detach(tables);
+
 	// clear previously loaded tables
-	tabLorentz.clear();
-	tabRedshifts.clear();
-	tabProtonRate.clear();
-	tabNeutronRate.clear();
+	tables->tabLorentz.clear();
+	tables->tabRedshifts.clear();
+	tables->tabProtonRate.clear();
+	tables->tabNeutronRate.clear();
 
-	std::ifstream infile(filename.c_str());
-	if (!infile.good())
+	DataTable table(filename);
+	if (!table.good())
 		throw std::runtime_error("PhotoPionProduction: could not open file " + filename);
 
+	const double *v = table.data();
 	if (haveRedshiftDependence) {
+		// records: z, log10(Lorentz factor), proton rate, neutron rate
 		double zOld = -1, aOld = -1;
-		while (infile.good()) {
-			if (infile.peek() == '#') {
-				infile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-				continue;
-			}
-			double z, a, b, c;
-			infile >> z >> a >> b >> c;
-			if (!infile)
-				break;
+		for (size_t i = 0; i + 4 <= table.size(); i += 4) {
+			double z = v[i], a = v[i + 1];
 			if (z > zOld) {
-				tabRedshifts.push_back(z);
+				tables->tabRedshifts.push_back(z);
 				zOld = z;
 			}
 			if (a > aOld) {
-				tabLorentz.push_back(pow(10, a));
+				tables->tabLorentz.push_back(pow(10, a));
 				aOld = a;
 			}
-			tabProtonRate.push_back(b / Mpc);
-			tabNeutronRate.push_back(c / Mpc);
+			tables->tabProtonRate.push_back(v[i + 2] / Mpc);
+			tables->tabNeutronRate.push_back(v[i + 3] / Mpc);
 		}
 	} else {
-		while (infile.good()) {
-			if (infile.peek() == '#') {
-				infile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-				continue;
-			}
-			double a, b, c;
-			infile >> a >> b >> c;
-			if (!infile)
-				break;
-			tabLorentz.push_back(pow(10, a));
-			tabProtonRate.push_back(b / Mpc);
-			tabNeutronRate.push_back(c / Mpc);
+		// records: log10(Lorentz factor), proton rate, neutron rate
+		for (size_t i = 0; i + 3 <= table.size(); i += 3) {
+			tables->tabLorentz.push_back(pow(10, v[i]));
+			tables->tabProtonRate.push_back(v[i + 1] / Mpc);
+			tables->tabNeutronRate.push_back(v[i + 2] / Mpc);
 		}
 	}
 
-	infile.close();
+	if (tables->tabLorentz.size() < 2)
+		return;
+	if (haveRedshiftDependence) {
+		tables->protonRate2D = UniformLogTable2D(tables->tabRedshifts, tables->tabLorentz, tables->tabProtonRate);
+		tables->neutronRate2D = UniformLogTable2D(tables->tabRedshifts, tables->tabLorentz, tables->tabNeutronRate);
+	} else {
+		tables->protonRate = UniformLogTable(tables->tabLorentz, tables->tabProtonRate);
+		tables->neutronRate = UniformLogTable(tables->tabLorentz, tables->tabNeutronRate);
+	}
 }
 
 double PhotoPionProduction::nucleonMFP(double gamma, double z, bool onProton) const {
-	const std::vector<double> &tabRate = (onProton)? tabProtonRate : tabNeutronRate;
-
 	// scale nucleus energy instead of background photon energy
 	gamma *= (1 + z);
-	if (gamma < tabLorentz.front() or (gamma > tabLorentz.back()))
+	if (gamma < tables->tabLorentz.front() or (gamma > tables->tabLorentz.back()))
 		return std::numeric_limits<double>::max();
 
 	double rate;
 	if (haveRedshiftDependence)
-		rate = interpolate2d(z, gamma, tabRedshifts, tabLorentz, tabRate);
+		rate = (onProton ? tables->protonRate2D : tables->neutronRate2D).interpolate(z, gamma);
 	else
-		rate = interpolate(gamma, tabLorentz, tabRate) * photonField->getRedshiftScaling(z);
+		rate = (onProton ? tables->protonRate : tables->neutronRate).interpolate(gamma) * photonField->getRedshiftScaling(z);
 
 	// cosmological scaling
 	rate *= pow_integer<2>(1 + z);
@@ -152,6 +258,43 @@ double PhotoPionProduction::nucleiModification(int A, int X) const {
 	return 0.85 * X;
 }
 
+unsigned int PhotoPionProduction::getParticleClasses() const {
+	return ParticleClassNucleus;
+}
+
+double PhotoPionProduction::interactionRate(const Candidate *candidate) const {
+	int id = candidate->current.getId();
+	if (!isNucleus(id))
+		return 0;
+
+	int A = massNumber(id);
+	int Z = chargeNumber(id);
+	int N = A - Z;
+	double gamma = candidate->current.getLorentzFactor();
+	double z = candidate->getRedshift();
+	double rate = 0;
+	if (Z > 0)
+		rate += nucleiModification(A, Z) / nucleonMFP(gamma, z, true);
+	if (N > 0)
+		rate += nucleiModification(A, N) / nucleonMFP(gamma, z, false);
+	return rate;
+}
+
+void PhotoPionProduction::interact(Candidate *candidate) const {
+	int id = candidate->current.getId();
+	int A = massNumber(id);
+	int Z = chargeNumber(id);
+	int N = A - Z;
+	double gamma = candidate->current.getLorentzFactor();
+	double z = candidate->getRedshift();
+
+	// select the interacting nucleon by its share of the rate
+	double protonRate = (Z > 0) ? nucleiModification(A, Z) / nucleonMFP(gamma, z, true) : 0;
+	double neutronRate = (N > 0) ? nucleiModification(A, N) / nucleonMFP(gamma, z, false) : 0;
+	bool onProton = Random::instance().rand() * (protonRate + neutronRate) < protonRate;
+	performInteraction(candidate, onProton);
+}
+
 void PhotoPionProduction::process(Candidate *candidate) const {
 	double step = candidate->getCurrentStep();
 	double z = candidate->getRedshift();
@@ -232,12 +375,19 @@ void PhotoPionProduction::performInteraction(Candidate *candidate, bool onProton
 	int outPartID[2000];
 	int nParticles;
 
-#pragma omp critical
-	{
+	Random &random = Random::instance();
+	size_t first, last;
+	if (eventLibrary and eventLibrary->sample(onProton, Ein * GeV, eps * GeV, random, first, last)) {
+		nParticles = last - first;
+		for (int i = 0; i < nParticles; i++) {
+			outPartID[i] = eventLibrary->getId(first + i);
+			outputEnergy[3][i] = eventLibrary->getEnergyFraction(first + i) * Ein;
+		}
+	} else {
+#pragma omp critical(SOPHIA)
 		sophiaevent_(nature, Ein, eps, outputEnergy, outPartID, nParticles);
 	}
 
-	Random &random = Random::instance();
 	Vector3d pos = random.randomInterpolatedPosition(candidate->previous.getPosition(), candidate->current.getPosition());
 	std::vector<int> pnType;  // filled with either 13 (proton) or 14 (neutron)
 	std::vector<double> pnEnergy;  // corresponding energies of proton or neutron
@@ -367,6 +517,7 @@ SophiaEventOutput PhotoPionProduction::sophiaEvent(bool onProton, double Ein, do
 	int outPartID[2000];
 	int nParticles;
 
+#pragma omp critical(SOPHIA)
 	sophiaevent_(nature, Ein, eps, outputEnergy, outPartID, nParticles);
 
 	// convert SOPHIA IDs to PDG naming convention & create particles
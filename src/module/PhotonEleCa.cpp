@@ -21,6 +21,10 @@ PhotonEleCa::PhotonEleCa(const std::string background,
 PhotonEleCa::~PhotonEleCa() {
 }
 
+unsigned int PhotonEleCa::getParticleClasses() const {
+	return ParticleClassPhoton;
+}
+
 void PhotonEleCa::process(Candidate *candidate) const {
 	if (candidate->current.getId() != 22)
 		return; // do nothing if not a photon
@@ -44,6 +44,10 @@ PhotonOutput1D::PhotonOutput1D(const std::string &filename) : outfile(
 	*out << "#\n";
 }
 
+unsigned int PhotonOutput1D::getParticleClasses() const {
+	return ParticleClassPhoton | ParticleClassElectron;
+}
+
 void PhotonOutput1D::process(Candidate *candidate) const {
 	int pid = candidate->current.getId();
 	if ((pid != 22) and (abs(pid) != 11))
@@ -1,4 +1,5 @@
 #include "crpropa/module/PropagationBP.h"
+#include "crpropa/module/SimplePropagation.h"
 
 #include <sstream>
 #include <stdexcept>
@@ -41,7 +42,7 @@ namespace crpropa {
 
 	// with a fixed step size
 	PropagationBP::PropagationBP(ref_ptr<MagneticField> field, double fixedStep) :
-			minStep(0) {
+			minStep(0), eventDrivenNeutrals(false) {
 		setField(field);
 		setTolerance(0.42);
 		setMaximumStep(fixedStep);
@@ -51,7 +52,7 @@ namespace crpropa {
 
 	// with adaptive step size
 	PropagationBP::PropagationBP(ref_ptr<MagneticField> field, double tolerance, double minStep, double maxStep) :
-			minStep(0) {
+			minStep(0), eventDrivenNeutrals(false) {
 		setField(field);
 		setTolerance(tolerance);
 		setMaximumStep(maxStep);
@@ -69,12 +70,7 @@ namespace crpropa {
 
 		// rectilinear propagation for neutral particles
 		if (q == 0) {
-			double step = clip(candidate->getNextStep(), minStep, maxStep);
-			Vector3d pos = current.getPosition();
-			Vector3d dir = current.getDirection();
-			current.setPosition(pos + dir * step);
-			candidate->setCurrentStep(step);
-			candidate->setNextStep(maxStep);
+			propagateNeutral(candidate, minStep, maxStep, eventDrivenNeutrals);
 			return;
 		}
 
@@ -200,6 +196,14 @@ namespace crpropa {
 	}
 
 
+	void PropagationBP::setEventDrivenNeutrals(bool b) {
+		eventDrivenNeutrals = b;
+	}
+
+	bool PropagationBP::isEventDrivenNeutrals() const {
+		return eventDrivenNeutrals;
+	}
+
 	double PropagationBP::getMaximumStep() const {
 		return maxStep;
 	}
@@ -1,5 +1,7 @@
 #include "crpropa/module/PropagationCK.h"
+#include "crpropa/module/SimplePropagation.h"
 
+#include <cmath>
 #include <limits>
 #include <sstream>
 #include <stdexcept>
@@ -27,8 +29,7 @@ const double cash_karp_bs[] = {
 
 void PropagationCK::tryStep(const Y &y, Y &out, Y &error, double h,
 		ParticleState &particle, double z) const {
-	std::vector<Y> k;
-	k.reserve(6);
+	Y k[6];
 
 	out = y;
 	error = Y(0);
@@ -65,7 +66,7 @@ PropagationCK::Y PropagationCK::dYdt(const Y &y, ParticleState &p, double z) con
 
 PropagationCK::PropagationCK(ref_ptr<MagneticField> field, double tolerance,
 		double minStep, double maxStep) :
-		minStep(0) {
+		minStep(0), eventDrivenNeutrals(false) {
 	setField(field);
 	setTolerance(tolerance);
 	setMaximumStep(maxStep);
@@ -82,18 +83,14 @@ void PropagationCK::process(Candidate *candidate) const {
 	ParticleState &current = candidate->current;
 	candidate->previous = current;
 
-	double step = clip(candidate->getNextStep(), minStep, maxStep);
-
 	// rectilinear propagation for neutral particles
 	if (current.getCharge() == 0) {
-		Vector3d pos = current.getPosition();
-		Vector3d dir = current.getDirection();
-		current.setPosition(pos + dir * step);
-		candidate->setCurrentStep(step);
-		candidate->setNextStep(maxStep);
+		propagateNeutral(candidate, minStep, maxStep, eventDrivenNeutrals);
 		return;
 	}
 
+	double step = clip(candidate->getNextStep(), minStep, maxStep);
+
 	Y yIn(current.getPosition(), current.getDirection());
 	Y yOut, yErr;
 	double newStep = step;
@@ -120,6 +117,143 @@ void PropagationCK::process(Candidate *candidate) const {
 	candidate->setNextStep(newStep);
 }
 
+void PropagationCK::processBatch(Candidate **candidates, size_t n) const {
+	Candidate *lanes[batchWidth];
+	size_t m = 0;
+	for (size_t i = 0; i < n; i++) {
+		if (candidates[i]->current.getCharge() == 0) {
+			PropagationCK::process(candidates[i]);
+			continue;
+		}
+		lanes[m++] = candidates[i];
+		if (m == batchWidth) {
+			processLanes(lanes, m);
+			m = 0;
+		}
+	}
+	if (m > 0)
+		processLanes(lanes, m);
+}
+
+void PropagationCK::processLanes(Candidate **candidates, size_t m) const {
+	const size_t W = batchWidth;
+	// phase points (x, u) in structure-of-arrays layout, one lane per candidate
+	double y[6][W], yn[6][W], out[6][W], err[6][W], k[6][6][W], result[6][W];
+	double f[W], z[W], step[W], newStep[W], h[W];
+	bool pending[W];
+
+	// unused lanes repeat the first candidate and are never pending
+	for (size_t l = 0; l < W; l++) {
+		Candidate *candidate = candidates[(l < m) ? l : 0];
+		ParticleState &current = candidate->current;
+		if (l < m)
+			candidate->previous = current;
+		Vector3d x = current.getPosition();
+		Vector3d u = current.getDirection();
+		y[0][l] = x.x;
+		y[1][l] = x.y;
+		y[2][l] = x.z;
+		y[3][l] = u.x;
+		y[4][l] = u.y;
+		y[5][l] = u.z;
+		f[l] = current.getCharge() * c_light / current.getEnergy();
+		z[l] = candidate->getRedshift();
+		step[l] = clip(candidate->getNextStep(), minStep, maxStep);
+		newStep[l] = step[l];
+		pending[l] = (l < m);
+	}
+
+	// try performing steps until all lanes reached the target error or the minimum step size
+	size_t nPending = m;
+	while (nPending > 0) {
+		for (size_t l = 0; l < W; l++) {
+			if (pending[l])
+				step[l] = newStep[l];
+			h[l] = step[l] / c_light;
+		}
+		for (size_t c = 0; c < 6; c++) {
+			for (size_t l = 0; l < W; l++) {
+				out[c][l] = y[c][l];
+				err[c][l] = 0;
+			}
+		}
+
+		for (size_t i = 0; i < 6; i++) {
+			for (size_t c = 0; c < 6; c++) {
+				for (size_t l = 0; l < W; l++)
+					yn[c][l] = y[c][l];
+				for (size_t j = 0; j < i; j++) {
+					double aij = a[i * 6 + j];
+					for (size_t l = 0; l < W; l++)
+						yn[c][l] += k[j][c][l] * aij * h[l];
+				}
+			}
+
+			// magnetic field of the pending lanes
+			double B[3][W];
+			for (size_t l = 0; l < W; l++) {
+				Vector3d Bl(0, 0, 0);
+				if (pending[l]) {
+					try {
+						Bl = field->getField(Vector3d(yn[0][l], yn[1][l], yn[2][l]), z[l]);
+					} catch (std::exception &e) {
+						std::cerr << "PropagationCK: Exception in getField." << std::endl;
+						std::cerr << e.what() << std::endl;
+					}
+				}
+				B[0][l] = Bl.x;
+				B[1][l] = Bl.y;
+				B[2][l] = Bl.z;
+			}
+
+			// derivative of the phase point, see dYdt
+			double *v[3] = {k[i][0], k[i][1], k[i][2]};
+			for (size_t l = 0; l < W; l++) {
+				double norm = std::sqrt(yn[3][l] * yn[3][l] + yn[4][l] * yn[4][l] + yn[5][l] * yn[5][l]);
+				v[0][l] = yn[3][l] / norm * c_light;
+				v[1][l] = yn[4][l] / norm * c_light;
+				v[2][l] = yn[5][l] / norm * c_light;
+				k[i][3][l] = f[l] * (v[1][l] * B[2][l] - B[1][l] * v[2][l]);
+				k[i][4][l] = f[l] * (v[2][l] * B[0][l] - B[2][l] * v[0][l]);
+				k[i][5][l] = f[l] * (v[0][l] * B[1][l] - B[0][l] * v[1][l]);
+			}
+
+			double bi = b[i];
+			double ei = b[i] - bs[i];
+			for (size_t c = 0; c < 6; c++) {
+				for (size_t l = 0; l < W; l++) {
+					out[c][l] += k[i][c][l] * bi * h[l];
+					err[c][l] += k[i][c][l] * ei * h[l];
+				}
+			}
+		}
+
+		// accept the lanes that reached the target error or the minimum step
+		for (size_t l = 0; l < W; l++) {
+			if (not pending[l])
+				continue;
+			double r = std::sqrt(err[3][l] * err[3][l] + err[4][l] * err[4][l] + err[5][l] * err[5][l]) / tolerance;
+			newStep[l] = step[l] * 0.95 * pow(r, -0.2);
+			newStep[l] = clip(newStep[l], 0.1 * step[l], 5 * step[l]);
+			newStep[l] = clip(newStep[l], minStep, maxStep);
+			if ((not (r > 1)) or (step[l] == minStep)) {
+				for (size_t c = 0; c < 6; c++)
+					result[c][l] = out[c][l];
+				pending[l] = false;
+				nPending--;
+			}
+		}
+	}
+
+	for (size_t l = 0; l < m; l++) {
+		ParticleState &current = candidates[l]->current;
+		current.setPosition(Vector3d(result[0][l], result[1][l], result[2][l]));
+		current.setDirection(Vector3d(result[3][l], result[4][l], result[5][l]).getUnitVector());
+		candidates[l]->setCurrentStep(step[l]);
+		candidates[l]->setNextStep(newStep[l]);
+	}
+}
+
 void PropagationCK::setField(ref_ptr<MagneticField> f) {
 	field = f;
 }
@@ -153,6 +287,14 @@ double PropagationCK::getMinimumStep() const {
 	return minStep;
 }
 
+void PropagationCK::setEventDrivenNeutrals(bool b) {
+	eventDrivenNeutrals = b;
+}
+
+bool PropagationCK::isEventDrivenNeutrals() const {
+	return eventDrivenNeutrals;
+}
+
 double PropagationCK::getMaximumStep() const {
 	return maxStep;
 }
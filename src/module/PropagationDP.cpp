@@ -0,0 +1,231 @@
+#include "crpropa/module/PropagationDP.h"
+#include "crpropa/module/SimplePropagation.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <vector>
+
+namespace crpropa {
+
+// Dormand-Prince coefficients
+const double dormand_prince_a[] = {
+	0., 0., 0., 0., 0., 0., 0.,
+	1. / 5., 0., 0., 0., 0., 0., 0.,
+	3. / 40., 9. / 40., 0., 0., 0., 0., 0.,
+	44. / 45., -56. / 15., 32. / 9., 0., 0., 0., 0.,
+	19372. / 6561., -25360. / 2187., 64448. / 6561., -212. / 729., 0., 0., 0.,
+	9017. / 3168., -355. / 33., 46732. / 5247., 49. / 176., -5103. / 18656., 0., 0.,
+	35. / 384., 0., 500. / 1113., 125. / 192., -2187. / 6784., 11. / 84., 0.
+};
+
+// 5th order weights, equal to the last stage (first same as last)
+const double dormand_prince_b[] = {
+	35. / 384., 0., 500. / 1113., 125. / 192., -2187. / 6784., 11. / 84., 0.
+};
+
+// difference of the 5th and 4th order weights
+const double dormand_prince_e[] = {
+	71. / 57600., 0., -71. / 16695., 71. / 1920., -17253. / 339200., 22. / 525., -1. / 40.
+};
+
+namespace {
+
+const size_t cacheSize = 64; // cached fields per thread
+uint64_t nextFieldVersion = 1;
+
+} // namespace
+
+PropagationDP::PropagationDP(ref_ptr<MagneticField> field, double tolerance,
+		double minStep, double maxStep) :
+		minStep(0), eventDrivenNeutrals(false), fieldVersion(0) {
+	setField(field);
+	setTolerance(tolerance);
+	setMaximumStep(maxStep);
+	setMinimumStep(minStep);
+
+	// load Dormand-Prince coefficients
+	a.assign(dormand_prince_a, dormand_prince_a + 49);
+	b.assign(dormand_prince_b, dormand_prince_b + 7);
+	e.assign(dormand_prince_e, dormand_prince_e + 7);
+}
+
+void PropagationDP::tryStep(const Y &y, const Y &k0, Y &out, Y &error,
+		Vector3d &Bout, double h, ParticleState &particle, double z) const {
+	Y k[7];
+	k[0] = k0;
+
+	out = y;
+	error = Y(0);
+	out += k[0] * b[0] * h;
+	error += k[0] * e[0] * h;
+
+	for (size_t i = 1; i < 7; i++) {
+		Y y_n = y;
+		for (size_t j = 0; j < i; j++)
+			y_n += k[j] * a[i * 7 + j] * h;
+
+		// the last stage is evaluated at the end point of the step
+		Vector3d B = getFieldAtPosition(y_n.x, z);
+		k[i] = dYdt(y_n, particle, B);
+		if (i == 6)
+			Bout = B;
+
+		out += k[i] * b[i] * h;
+		error += k[i] * e[i] * h;
+	}
+}
+
+PropagationDP::Y PropagationDP::dYdt(const Y &y, ParticleState &p, const Vector3d &B) const {
+	// normalize direction vector to prevent numerical losses
+	Vector3d velocity = y.u.getUnitVector() * c_light;
+	// Lorentz force: du/dt = q*c/E * (v x B)
+	Vector3d dudt = p.getCharge() * c_light / p.getEnergy() * velocity.cross(B);
+	return Y(velocity, dudt);
+}
+
+Vector3d PropagationDP::getFieldAtPosition(const Vector3d &pos, double z) const {
+	Vector3d B(0, 0, 0);
+	try {
+		B = field->getField(pos, z);
+	} catch (std::exception &e) {
+		std::cerr << "PropagationDP: Exception in getField." << std::endl;
+		std::cerr << e.what() << std::endl;
+	}
+	return B;
+}
+
+PropagationDP::CachedField &PropagationDP::cacheEntry(const Candidate *candidate) const {
+	static thread_local std::vector<CachedField> cache;
+	if (cache.empty()) {
+		CachedField empty;
+		empty.fieldVersion = 0;
+		empty.candidate = 0;
+		empty.z = 0;
+		cache.assign(cacheSize, empty);
+	}
+	return cache[(reinterpret_cast<uintptr_t>(candidate) / sizeof(Candidate)) % cacheSize];
+}
+
+void PropagationDP::process(Candidate *candidate) const {
+	// save the new previous particle state
+	ParticleState &current = candidate->current;
+	candidate->previous = current;
+
+	// rectilinear propagation for neutral particles
+	if (current.getCharge() == 0) {
+		propagateNeutral(candidate, minStep, maxStep, eventDrivenNeutrals);
+		return;
+	}
+
+	double step = clip(candidate->getNextStep(), minStep, maxStep);
+
+	Y yIn(current.getPosition(), current.getDirection());
+	double z = candidate->getRedshift();
+
+	// first stage, reusing the field of the last step if the candidate has not been moved since
+	CachedField &cached = cacheEntry(candidate);
+	Vector3d B0;
+	if ((cached.fieldVersion == fieldVersion) and (cached.candidate == candidate)
+			and (cached.position == yIn.x) and (cached.z == z))
+		B0 = cached.field;
+	else
+		B0 = getFieldAtPosition(yIn.x, z);
+	Y k0 = dYdt(yIn, current, B0);
+
+	Y yOut, yErr;
+	Vector3d BOut;
+	double newStep = step;
+	double r = 42;  // arbitrary value > 1
+
+	// try performing step until the target error (tolerance) or the minimum step size has been reached
+	while (r > 1) {
+		step = newStep;
+		tryStep(yIn, k0, yOut, yErr, BOut, step / c_light, current, z);
+
+		r = yErr.u.getR() / tolerance;  // ratio of absolute direction error and tolerance
+		newStep = step * 0.95 * pow(r, -0.2);  // update step size to keep error close to tolerance
+		newStep = clip(newStep, 0.1 * step, 5 * step);  // limit the step size change
+		newStep = clip(newStep, minStep, maxStep);
+
+		if (step == minStep)
+			break;  // performed step already at the minimum
+	}
+
+	current.setPosition(yOut.x);
+	current.setDirection(yOut.u.getUnitVector());
+	candidate->setCurrentStep(step);
+	candidate->setNextStep(newStep);
+
+	cached.fieldVersion = fieldVersion;
+	cached.candidate = candidate;
+	cached.position = current.getPosition();
+	cached.z = z;
+	cached.field = BOut;
+}
+
+void PropagationDP::setField(ref_ptr<MagneticField> f) {
+	field = f;
+	// a new version, so that the fields cached for the previous field or
+	// another instance are not used
+#pragma omp critical(PropagationDP)
+	fieldVersion = nextFieldVersion++;
+}
+
+void PropagationDP::setTolerance(double tol) {
+	if ((tol > 1) or (tol < 0))
+		throw std::runtime_error(
+				"PropagationDP: target error not in range 0-1");
+	tolerance = tol;
+}
+
+void PropagationDP::setMinimumStep(double min) {
+	if (min < 0)
+		throw std::runtime_error("PropagationDP: minStep < 0 ");
+	if (min > maxStep)
+		throw std::runtime_error("PropagationDP: minStep > maxStep");
+	minStep = min;
+}
+
+void PropagationDP::setMaximumStep(double max) {
+	if (max < minStep)
+		throw std::runtime_error("PropagationDP: maxStep < minStep");
+	maxStep = max;
+}
+
+ref_ptr<MagneticField> PropagationDP::getField() const {
+	return field;
+}
+
+double PropagationDP::getTolerance() const {
+	return tolerance;
+}
+
+double PropagationDP::getMinimumStep() const {
+	return minStep;
+}
+
+void PropagationDP::setEventDrivenNeutrals(bool b) {
+	eventDrivenNeutrals = b;
+}
+
+bool PropagationDP::isEventDrivenNeutrals() const {
+	return eventDrivenNeutrals;
+}
+
+double PropagationDP::getMaximumStep() const {
+	return maxStep;
+}
+
+std::string PropagationDP::getDescription() const {
+	std::stringstream s;
+	s << "Propagation in magnetic fields using the Dormand-Prince method.";
+	s << " Target error: " << tolerance;
+	s << ", Minimum Step: " << minStep / kpc << " kpc";
+	s << ", Maximum Step: " << maxStep / kpc << " kpc";
+	return s.str();
+}
+
+} // namespace crpropa
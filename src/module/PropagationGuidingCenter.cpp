@@ -0,0 +1,246 @@
+#include "crpropa/module/PropagationGuidingCenter.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace crpropa {
+
+PropagationGuidingCenter::PropagationGuidingCenter(
+		ref_ptr<MagneticField> field, double adiabaticity, double tolerance,
+		double minStep, double maxStep) :
+		minStep(0) {
+	setMaximumStep(maxStep);
+	setMinimumStep(minStep);
+	setAdiabaticity(adiabaticity);
+	setTolerance(tolerance);
+	setFullOrbitPropagation(new PropagationCK(field, 1e-4, minStep, maxStep));
+	setField(field);
+}
+
+Vector3d PropagationGuidingCenter::getFieldAtPosition(const Vector3d &pos,
+		double z) const {
+	Vector3d B(0, 0, 0);
+	try {
+		B = field->getField(pos, z);
+	} catch (std::exception &e) {
+		std::cerr << "PropagationGuidingCenter: Exception in getField." << std::endl;
+		std::cerr << e.what() << std::endl;
+	}
+	return B;
+}
+
+PropagationGuidingCenter::FieldPoint PropagationGuidingCenter::getFieldPoint(
+		const Vector3d &pos, double z, double d) const {
+	FieldPoint f;
+	f.B = getFieldAtPosition(pos, z);
+	f.Bmag = f.B.getR();
+	f.b = Vector3d(0.);
+	f.gradB = Vector3d(0.);
+	f.curvature = Vector3d(0.);
+	if (f.Bmag == 0)
+		return f;
+	f.b = f.B / f.Bmag;
+
+	// central differences of the field vector along the coordinate axes
+	Vector3d J[3];
+	for (size_t i = 0; i < 3; i++) {
+		Vector3d e(0.);
+		e.data[i] = d;
+		J[i] = (getFieldAtPosition(pos + e, z) - getFieldAtPosition(pos - e, z)) / (2 * d);
+	}
+
+	// grad |B| = (b . dB/dx_i)_i, (b . grad) B = sum_i b_i dB/dx_i
+	Vector3d bGradB(0.);
+	for (size_t i = 0; i < 3; i++) {
+		f.gradB.data[i] = f.b.dot(J[i]);
+		bGradB += J[i] * f.b.data[i];
+	}
+	// (b . grad) b is the part of (b . grad) B / |B| perpendicular to b
+	f.curvature = (bGradB - f.b * f.b.dot(bGradB)) / f.Bmag;
+	return f;
+}
+
+double PropagationGuidingCenter::scaleLength(const FieldPoint &f) const {
+	double L = std::numeric_limits<double>::infinity();
+	double g = f.gradB.getR();
+	if (g > 0)
+		L = f.Bmag / g;
+	double k = f.curvature.getR();
+	if (k > 0)
+		L = std::min(L, 1 / k);
+	return L;
+}
+
+void PropagationGuidingCenter::derivative(const FieldPoint &f, double vPar,
+		double rigidity, Vector3d &dXdt, double &dvdt) const {
+	double vPerp2 = std::max(c_squared - vPar * vPar, 0.);
+	// gradient and curvature drift: E / (q c^2 B) * (v_perp^2 / 2 * b x grad|B| / |B| + v_par^2 * b x curvature)
+	Vector3d drift = f.b.cross(f.gradB) * (0.5 * vPerp2 / f.Bmag)
+			+ f.b.cross(f.curvature) * (vPar * vPar);
+	dXdt = f.b * vPar + drift * (rigidity / (c_light * f.Bmag));
+	// mirror force, conserving the magnetic moment
+	dvdt = -0.5 * vPerp2 / f.Bmag * f.b.dot(f.gradB);
+}
+
+void PropagationGuidingCenter::process(Candidate *candidate) const {
+	ParticleState &current = candidate->current;
+	double q = current.getCharge();
+	if (q == 0) {
+		fullOrbit->process(candidate);
+		return;
+	}
+
+	double z = candidate->getRedshift();
+	Vector3d x = current.getPosition();
+	Vector3d u = current.getDirection();
+
+	Vector3d B = getFieldAtPosition(x, z);
+	double Bmag = B.getR();
+	if (Bmag == 0) {
+		fullOrbit->process(candidate);
+		return;
+	}
+
+	// signed rigidity R = E / (q c); gyroradius R / B and gyrofrequency c B / R for v_perp = c
+	double rigidity = current.getEnergy() / (q * c_light);
+	double rg = std::fabs(rigidity) / Bmag;
+
+	// guiding center X = x - rho with the gyration vector rho = R / (c B) * b x v
+	Vector3d b = B / Bmag;
+	double vPar = c_light * u.dot(b);
+	Vector3d ePerp = u - b * u.dot(b);
+	Vector3d X = x - b.cross(ePerp) * rg * (rigidity > 0 ? 1 : -1);
+
+	// adiabaticity: gyroradius small against the field scale length
+	FieldPoint f0 = getFieldPoint(X, z, rg);
+	if (f0.Bmag == 0) {
+		fullOrbit->process(candidate);
+		return;
+	}
+	// gyration vector with the field at the guiding center, as for the conversion back
+	b = f0.b;
+	vPar = c_light * u.dot(b);
+	ePerp = u - b * u.dot(b);
+	X = x - b.cross(ePerp) * (std::fabs(rigidity) / f0.Bmag) * (rigidity > 0 ? 1 : -1);
+	double L = scaleLength(f0);
+	if (rg > adiabaticity * L) {
+		fullOrbit->process(candidate);
+		return;
+	}
+
+	candidate->previous = current;
+	double step = std::min(candidate->getNextStep(), tolerance * L);
+	step = clip(step, minStep, maxStep);
+	double h = step / c_light;
+
+	// midpoint method for the guiding center and the parallel velocity
+	Vector3d dXdt;
+	double dvdt;
+	derivative(f0, vPar, rigidity, dXdt, dvdt);
+	Vector3d Xm = X + dXdt * (0.5 * h);
+	double vParm = clip(vPar + dvdt * (0.5 * h), -c_light, c_light);
+	FieldPoint fm = getFieldPoint(Xm, z, rg);
+	derivative(fm, vParm, rigidity, dXdt, dvdt);
+	X += dXdt * h;
+	vPar = clip(vPar + dvdt * h, -c_light, c_light);
+
+	// back to the particle: advance the gyration phase and add the gyration vector
+	Vector3d B1 = getFieldAtPosition(X, z);
+	double B1mag = B1.getR();
+	Vector3d b1 = (B1mag > 0) ? B1 / B1mag : b;
+	double phase = std::fmod(c_light * fm.Bmag / rigidity * h, 2 * M_PI);
+	ePerp = ePerp.getRotated(b, -phase);
+	ePerp = ePerp - b1 * ePerp.dot(b1);
+	if (ePerp.getR2() > 0)
+		ePerp = ePerp.getUnitVector();
+	double vPerp = std::sqrt(std::max(c_squared - vPar * vPar, 0.));
+
+	Vector3d u1 = b1 * vPar + ePerp * vPerp;
+	double rg1 = (B1mag > 0) ? std::fabs(rigidity) / B1mag : rg;
+	Vector3d x1 = X + b1.cross(ePerp) * (rg1 * vPerp / c_light) * (rigidity > 0 ? 1 : -1);
+
+	current.setPosition(x1);
+	current.setDirection(u1.getUnitVector());
+	candidate->setCurrentStep(step);
+	candidate->setNextStep(clip(tolerance * scaleLength(fm), minStep, maxStep));
+}
+
+void PropagationGuidingCenter::setField(ref_ptr<MagneticField> f) {
+	field = f;
+	PropagationCK *ck = dynamic_cast<PropagationCK *>(fullOrbit.get());
+	if (ck)
+		ck->setField(f);
+}
+
+void PropagationGuidingCenter::setFullOrbitPropagation(ref_ptr<Module> propagation) {
+	if (not propagation.valid())
+		throw std::runtime_error("PropagationGuidingCenter: no full-orbit propagation");
+	fullOrbit = propagation;
+}
+
+void PropagationGuidingCenter::setAdiabaticity(double a) {
+	if ((a <= 0) or (a > 1))
+		throw std::runtime_error(
+				"PropagationGuidingCenter: adiabaticity not in range 0-1");
+	adiabaticity = a;
+}
+
+void PropagationGuidingCenter::setTolerance(double tol) {
+	if ((tol <= 0) or (tol > 1))
+		throw std::runtime_error(
+				"PropagationGuidingCenter: tolerance not in range 0-1");
+	tolerance = tol;
+}
+
+void PropagationGuidingCenter::setMinimumStep(double min) {
+	if (min < 0)
+		throw std::runtime_error("PropagationGuidingCenter: minStep < 0 ");
+	if (min > maxStep)
+		throw std::runtime_error("PropagationGuidingCenter: minStep > maxStep");
+	minStep = min;
+}
+
+void PropagationGuidingCenter::setMaximumStep(double max) {
+	if (max < minStep)
+		throw std::runtime_error("PropagationGuidingCenter: maxStep < minStep");
+	maxStep = max;
+}
+
+ref_ptr<MagneticField> PropagationGuidingCenter::getField() const {
+	return field;
+}
+
+ref_ptr<Module> PropagationGuidingCenter::getFullOrbitPropagation() const {
+	return fullOrbit;
+}
+
+double PropagationGuidingCenter::getAdiabaticity() const {
+	return adiabaticity;
+}
+
+double PropagationGuidingCenter::getTolerance() const {
+	return tolerance;
+}
+
+double PropagationGuidingCenter::getMinimumStep() const {
+	return minStep;
+}
+
+double PropagationGuidingCenter::getMaximumStep() const {
+	return maxStep;
+}
+
+std::string PropagationGuidingCenter::getDescription() const {
+	std::stringstream s;
+	s << "Propagation in magnetic fields in the guiding center approximation.";
+	s << " Adiabaticity: " << adiabaticity;
+	s << ", Tolerance: " << tolerance;
+	s << ", Minimum Step: " << minStep / kpc << " kpc";
+	s << ", Maximum Step: " << maxStep / kpc << " kpc";
+	s << ", Full orbit: " << fullOrbit->getDescription();
+	return s.str();
+}
+
+} // namespace crpropa
@@ -14,7 +14,14 @@ void Redshift::process(Candidate *c) const {
 		return;
 
 	// use small step approximation:  dz = H(z) / c * ds
-	double dz = hubbleRate(z) / c_light * c->getCurrentStep();
+	double step = c->getCurrentStep();
+	double dz = hubbleRate(z) / c_light * step;
+
+	// large steps (e.g. event-driven neutral particles): exact relation of redshift and comoving distance
+	if ((dz > 1e-3) and (z < 100)) {
+		double d = redshift2ComovingDistance(z) - step;
+		dz = (d > 0) ? z - comovingDistance2Redshift(d) : z;
+	}
 
 	// prevent dz > z
 	dz = std::min(dz, z);
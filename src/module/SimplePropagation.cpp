@@ -1,12 +1,27 @@
 #include "crpropa/module/SimplePropagation.h"
 
+#include <limits>
 #include <sstream>
 #include <stdexcept>
 
 namespace crpropa {
 
+void propagateNeutral(Candidate *candidate, double minStep, double maxStep,
+		bool eventDriven) {
+	double step = candidate->getNextStep();
+	if (eventDriven)
+		step = std::max(step, minStep);
+	else
+		step = clip(step, minStep, maxStep);
+
+	ParticleState &current = candidate->current;
+	current.setPosition(current.getPosition() + current.getDirection() * step);
+	candidate->setCurrentStep(step);
+	candidate->setNextStep(eventDriven ? std::numeric_limits<double>::max() : maxStep);
+}
+
 SimplePropagation::SimplePropagation(double minStep, double maxStep) :
-		minStep(minStep), maxStep(maxStep) {
+		minStep(minStep), maxStep(maxStep), eventDrivenNeutrals(false) {
 	if (minStep > maxStep)
 		throw std::runtime_error("SimplePropagation: minStep > maxStep");
 }
@@ -14,6 +29,11 @@ SimplePropagation::SimplePropagation(double minStep, double maxStep) :
 void SimplePropagation::process(Candidate *c) const {
 	c->previous = c->current;
 
+	if (eventDrivenNeutrals and (c->current.getCharge() == 0)) {
+		propagateNeutral(c, minStep, maxStep, true);
+		return;
+	}
+
 	double step = std::max(minStep, c->getNextStep());
 	c->setCurrentStep(step);
 
@@ -36,6 +56,14 @@ void SimplePropagation::setMaximumStep(double step) {
 	maxStep = step;
 }
 
+void SimplePropagation::setEventDrivenNeutrals(bool b) {
+	eventDrivenNeutrals = b;
+}
+
+bool SimplePropagation::isEventDrivenNeutrals() const {
+	return eventDrivenNeutrals;
+}
+
 double SimplePropagation::getMinimumStep() const {
 	return minStep;
 }
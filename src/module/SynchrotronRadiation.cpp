@@ -2,6 +2,7 @@
 #include "crpropa/Units.h"
 #include "crpropa/Random.h"
 
+#include <algorithm>
 #include <fstream>
 #include <limits>
 #include <stdexcept>
@@ -13,18 +14,22 @@ SynchrotronRadiation::SynchrotronRadiation(ref_ptr<MagneticField> field, bool ha
 	setBrms(0);
 	initSpectrum();
 	setHavePhotons(havePhotons);
+	setThinning(thinning);
 	setLimit(limit);
 	setSecondaryThreshold(1e6 * eV);
 	setMaximumSamples(nSamples);
+	setAggregatePhotons(0);
 }
 
 SynchrotronRadiation::SynchrotronRadiation(double Brms, bool havePhotons, double thinning, int nSamples, double limit) {
 	setBrms(Brms);
 	initSpectrum();
 	setHavePhotons(havePhotons);
+	setThinning(thinning);
 	setLimit(limit);
 	setSecondaryThreshold(1e6 * eV);
 	setMaximumSamples(nSamples);
+	setAggregatePhotons(0);
 }
 
 void SynchrotronRadiation::setField(ref_ptr<MagneticField> f) {
@@ -83,6 +88,14 @@ double SynchrotronRadiation::getSecondaryThreshold() const {
 	return secondaryThreshold;
 }
 
+void SynchrotronRadiation::setAggregatePhotons(int n) {
+	aggregatePhotons = std::max(n, 0);
+}
+
+int SynchrotronRadiation::getAggregatePhotons() const {
+	return aggregatePhotons;
+}
+
 void SynchrotronRadiation::initSpectrum() {
 	std::string filename = getDataPath("Synchrotron/spectrum.txt");
 	std::ifstream infile(filename.c_str());
@@ -106,6 +119,53 @@ void SynchrotronRadiation::initSpectrum() {
 		infile.ignore(std::numeric_limits < std::streamsize > ::max(), '\n');
 	}
 	infile.close();
+
+	if (tabx.size() < 2)
+		throw std::runtime_error("SynchrotronRadiation: no spectrum in file " + filename);
+
+	// cumulative photon number and energy in the bins [tabx[i-1], tabx[i]],
+	// with x uniformly distributed within a bin
+	std::vector<double> number(tabx.size() - 1), energy(tabx.size() - 1);
+	double sumNumber = 0, sumEnergy = 0;
+	for (size_t i = 1; i < tabx.size(); i++) {
+		double dN = std::max(tabCDF[i] - tabCDF[i - 1], 0.);
+		sumNumber += dN;
+		sumEnergy += dN * (tabx[i - 1] + tabx[i]) / 2;
+		number[i - 1] = sumNumber;
+		energy[i - 1] = sumEnergy;
+	}
+	photonBins = AliasTable();
+	photonBins.add(number);
+	photonBins.add(energy);
+}
+
+double SynchrotronRadiation::drawPhotons(double Ecrit, double dE, std::vector<double> &energies, Random &random) const {
+	int counter = 0;
+	while (dE > 0) {
+		// draw a bin of x = E / Ecrit and x uniformly within the bin
+		size_t i = photonBins.sample(0, random) + 1;
+		double x = tabx[i - 1] + random.rand() * (tabx[i] - tabx[i - 1]);
+		double Ephoton = x * Ecrit;
+
+		// if the remaining energy is not sufficient check for random accepting
+		if (Ephoton > dE) {
+			if (random.rand() > (dE / Ephoton))
+				break; // not accepted
+		}
+
+		// only activate the "per-step" sampling if maximumSamples is explicitly set.
+		if ((maximumSamples > 0) and (counter >= maximumSamples))
+			break;
+
+		energies.push_back(Ephoton);
+		dE -= Ephoton;
+		counter++;
+	}
+	return dE;
+}
+
+unsigned int SynchrotronRadiation::getParticleClasses() const {
+	return ParticleClassElectron | ParticleClassNucleus | ParticleClassOther;
 }
 
 void SynchrotronRadiation::process(Candidate *candidate) const {
@@ -146,49 +206,38 @@ void SynchrotronRadiation::process(Candidate *candidate) const {
 	if (14 * Ecrit < secondaryThreshold)
 		return;
 
-	// draw photons up to the total energy loss
-	// if maximumSamples is reached before that, compensate the total energy afterwards
 	Random &random = Random::instance();
-	double dE0 = dE;
-	std::vector<double> energies;
-	int counter = 0;
-	while (dE > 0) {
-		// draw random value between 0 and maximum of corresponding cdf
-		// choose bin of s where cdf(x) = cdf_rand -> x_rand
-		size_t i = random.randBin(tabCDF); // draw random bin (upper bin boundary returned)
-		double binWidth = (tabx[i] - tabx[i-1]);
-		double x = tabx[i-1] + random.rand() * binWidth; // draw random x uniformly distributed in bin
-		double Ephoton = x * Ecrit;
 
-		// if the remaining energy is not sufficient check for random accepting
-		if (Ephoton > dE) {
-			if (random.rand() > (dE / Ephoton))
-				break; // not accepted
-		}
-
-		// only activate the "per-step" sampling if maximumSamples is explicitly set.
-		if (maximumSamples > 0) {
-			if (counter >= maximumSamples) 
-				break;			
+	// aggregate mode: photons drawn from the energy spectrum and weighted
+	// with 1 / Ephoton carry an equal share of the energy loss each
+	if (aggregatePhotons > 0) {
+		for (int i = 0; i < aggregatePhotons; i++) {
+			size_t k = photonBins.sample(1, random) + 1;
+			double x = tabx[k - 1] + random.rand() * (tabx[k] - tabx[k - 1]);
+			double Ephoton = x * Ecrit;
+			if (Ephoton <= secondaryThreshold)
+				continue; // create only photons with energies above threshold
+			double w = w0 * dE / aggregatePhotons / Ephoton;
+			Vector3d pos = random.randomInterpolatedPosition(candidate->previous.getPosition(), candidate->current.getPosition());
+			candidate->addSecondary(22, Ephoton, pos, w);
 		}
-
-		// store energies in array
-		energies.push_back(Ephoton);
-
-		// energy loss
-		dE -= Ephoton;
-
-		// counter for sampling break condition;
-		counter++;
+		return;
 	}
 
+	// draw photons up to the total energy loss
+	// if maximumSamples is reached before that, compensate the total energy afterwards
+	double dE0 = dE;
+	static thread_local std::vector<double> energies; // reused to avoid an allocation per step
+	energies.clear();
+	dE = drawPhotons(Ecrit, dE0, energies, random);
+
 	// while loop before gave total energy which is just a fraction of the required
 	double w1 = 1;
 	if (maximumSamples > 0 && dE > 0)
 		w1 = 1. / (1. - dE / dE0); 
 
 	// loop over sampled photons and attribute weights accordingly
-	for (int i = 0; i < energies.size(); i++) {
+	for (size_t i = 0; i < energies.size(); i++) {
 		double Ephoton = energies[i];
 		double f = Ephoton / (E - dE0);
 		double w = w0 * w1 / pow(f, thinning);
@@ -217,6 +266,8 @@ std::string SynchrotronRadiation::getDescription() const {
 		s << "maximum number of photon samples: " << maximumSamples;
 	if (thinning > 0)
 		s << "thinning parameter: " << thinning; 
+	if (aggregatePhotons > 0)
+		s << ", " << aggregatePhotons << " weighted photons per step";
 	return s.str();
 }
 
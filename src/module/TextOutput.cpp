@@ -249,9 +249,9 @@ void TextOutput::process(Candidate *c) const {
 			iter != properties.end(); ++iter)
 	{
 		  Variant v;
-			if (c->hasProperty((*iter).name))
+			if (c->hasProperty((*iter).key))
 			{
-				v = c->getProperty((*iter).name);
+				v = c->getProperty((*iter).key);
 			}
 			else
 			{
@@ -0,0 +1,90 @@
+#include "crpropa/module/WeightWindow.h"
+#include "crpropa/module/Acceleration.h"
+#include "crpropa/Random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace crpropa {
+
+WeightWindow::WeightWindow(int maximumSplits) :
+		particleClasses(0) {
+	setMaximumSplits(maximumSplits);
+}
+
+void WeightWindow::addWindow(double lower, double upper,
+		unsigned int classes, double minEnergy, double maxEnergy,
+		Surface *region) {
+	if (not ((lower > 0) and (lower < upper)))
+		throw std::runtime_error("WeightWindow: need 0 < lower < upper");
+	Window w;
+	w.lower = lower;
+	w.upper = upper;
+	w.survival = std::sqrt(lower * upper);
+	w.particleClasses = classes;
+	w.minEnergy = minEnergy;
+	w.maxEnergy = maxEnergy;
+	w.region = region;
+	windows.push_back(w);
+	particleClasses |= classes;
+}
+
+size_t WeightWindow::size() const {
+	return windows.size();
+}
+
+void WeightWindow::setMaximumSplits(int n) {
+	if (n < 2)
+		throw std::runtime_error("WeightWindow: the maximum number of splits must be at least 2");
+	maximumSplits = n;
+}
+
+int WeightWindow::getMaximumSplits() const {
+	return maximumSplits;
+}
+
+unsigned int WeightWindow::getParticleClasses() const {
+	return particleClasses;
+}
+
+void WeightWindow::process(Candidate *candidate) const {
+	unsigned int cls = particleClass(candidate->current.getId());
+	double E = candidate->current.getEnergy();
+
+	for (size_t i = 0; i < windows.size(); i++) {
+		const Window &w = windows[i];
+		if (not (w.particleClasses & cls))
+			continue;
+		if ((E < w.minEnergy) or (E > w.maxEnergy))
+			continue;
+		if (w.region.valid() and (w.region->distance(candidate->current.getPosition()) > 0))
+			continue;
+
+		double weight = candidate->getWeight();
+		if (weight > w.upper) {
+			int n = std::min(std::ceil(weight / w.survival), double(maximumSplits));
+			ParticleSplitting::split(candidate, n);
+		} else if (weight < w.lower) {
+			if (Random::instance().rand() * w.survival < weight)
+				candidate->setWeight(w.survival);
+			else
+				reject(candidate);
+		}
+		return;
+	}
+}
+
+std::string WeightWindow::getDescription() const {
+	std::stringstream s;
+	s << "WeightWindow: " << windows.size() << " windows, at most "
+			<< maximumSplits << " splits, ";
+	s << "Flag: '" << rejectFlagKey << "' -> '" << rejectFlagValue << "', ";
+	s << "MakeInactive: " << (makeRejectedInactive ? "yes" : "no");
+	if (rejectAction.valid())
+		s << ", Action: " << rejectAction->getDescription();
+	return s.str();
+}
+
+} // namespace crpropa
@@ -0,0 +1,28 @@
+// Writes the binary caches of CRPropa data tables, see crpropa::DataTable.
+// Usage: crpropa-convert-tables file.txt [file.txt ...]
+// The caches are written next to the text files as file.txt.bin.
+
+#include "crpropa/DataTable.h"
+
+#include <iostream>
+#include <stdexcept>
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " file.txt [file.txt ...]" << std::endl;
+		std::cerr << "Writes the binary cache file.txt.bin of each CRPropa data table." << std::endl;
+		return 1;
+	}
+
+	int failed = 0;
+	for (int i = 1; i < argc; i++) {
+		try {
+			crpropa::DataTable::convert(argv[i]);
+			std::cout << crpropa::DataTable::cacheName(argv[i]) << std::endl;
+		} catch (std::exception &e) {
+			std::cerr << e.what() << std::endl;
+			failed++;
+		}
+	}
+	return (failed == 0) ? 0 : 2;
+}
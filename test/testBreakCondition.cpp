@@ -5,8 +5,11 @@
 #include "crpropa/module/Boundary.h"
 #include "crpropa/module/Tools.h"
 #include "crpropa/module/RestrictToRegion.h"
+#include "crpropa/module/WeightWindow.h"
+#include "crpropa/module/Acceleration.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/Geometry.h"
+#include "crpropa/Units.h"
 
 #include "gtest/gtest.h"
 
@@ -499,6 +502,87 @@ TEST(RestrictToRegion, RestrictToRegion) {
 	EXPECT_FALSE(c.isActive());
 }
 
+TEST(ParticleSplitting, crossingThreshold) {
+	// split into numSplits candidates at every crossingThreshold-th crossing
+	ParticleSplitting splitting(new Plane(Vector3d(0.), Vector3d(1, 0, 0)), 3, 4);
+	Candidate c;
+	for (int i = 1; i <= 6; i++) {
+		double x = (i % 2) ? 1 : -1;
+		c.previous.setPosition(Vector3d(-x, 0, 0));
+		c.current.setPosition(Vector3d(x, 0, 0));
+		splitting.process(&c);
+		if (i == 3) {
+			EXPECT_EQ(3, c.secondaries.size());
+			EXPECT_DOUBLE_EQ(0.25, c.getWeight());
+		}
+	}
+	EXPECT_EQ(6, c.secondaries.size());
+	EXPECT_DOUBLE_EQ(1. / 16, c.getWeight());
+}
+
+TEST(WeightWindow, split) {
+	// Test if candidates above the window are split with the total weight kept.
+	WeightWindow ww(5);
+	ww.addWindow(1, 10);
+	Candidate c(nucleusId(1, 1), 1 * EeV);
+	c.setWeight(100);
+	ww.process(&c);
+	EXPECT_EQ(4, c.secondaries.size());
+	EXPECT_DOUBLE_EQ(20, c.getWeight());
+	for (size_t i = 0; i < c.secondaries.size(); i++) {
+		EXPECT_DOUBLE_EQ(20, c.secondaries[i]->getWeight());
+		EXPECT_EQ(c.current.getId(), c.secondaries[i]->current.getId());
+	}
+	EXPECT_TRUE(c.isActive());
+}
+
+TEST(WeightWindow, russianRoulette) {
+	// Test if Russian roulette keeps the expected total weight.
+	// This test can stochastically fail.
+	WeightWindow ww;
+	ww.addWindow(1, 4);
+	double weight = 0;
+	size_t N = 10000;
+	for (size_t i = 0; i < N; i++) {
+		Candidate c(nucleusId(1, 1), 1 * EeV);
+		c.setWeight(0.1);
+		ww.process(&c);
+		if (c.isActive()) {
+			EXPECT_DOUBLE_EQ(2, c.getWeight());
+			weight += c.getWeight();
+		} else {
+			EXPECT_TRUE(c.hasProperty("Rejected"));
+		}
+	}
+	EXPECT_NEAR(0.1 * N, weight, 0.1 * 0.1 * N);
+}
+
+TEST(WeightWindow, selection) {
+	// Test if only the first matching window applies.
+	WeightWindow ww;
+	ww.addWindow(1, 10, ParticleClassPhoton);
+	ww.addWindow(1, 10, ParticleClassAll, 1 * EeV, 10 * EeV, new Sphere(Vector3d(0, 0, 0), 10));
+	ww.addWindow(0.1, 1000);
+	EXPECT_EQ(ParticleClassAll, ww.getParticleClasses());
+
+	Candidate c(nucleusId(1, 1), 5 * EeV);
+	c.setWeight(100);
+	c.current.setPosition(Vector3d(20, 0, 0)); // outside of the region
+	ww.process(&c);
+	EXPECT_EQ(0, c.secondaries.size());
+
+	c.current.setPosition(Vector3d(5, 0, 0));
+	ww.process(&c);
+	EXPECT_EQ(9, c.secondaries.size());
+
+	Candidate photon(22, 100 * EeV);
+	photon.setWeight(0.5);
+	ww.process(&photon);
+	EXPECT_EQ(0, photon.secondaries.size());
+	EXPECT_TRUE((photon.getWeight() == 0.5 and not photon.isActive())
+			or (photon.getWeight() == std::sqrt(10.)));
+}
+
 
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
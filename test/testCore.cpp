@@ -5,9 +5,13 @@
   	Common functions
  */
 
+#include "crpropa/AliasTable.h"
 #include "crpropa/Candidate.h"
 #include "crpropa/base64.h"
 #include "crpropa/Common.h"
+#include "crpropa/DataTable.h"
+#include "crpropa/TableRegistry.h"
+#include "crpropa/UniformLogTable.h"
 #include "crpropa/Units.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/ParticleMass.h"
@@ -18,6 +22,8 @@
 #include "crpropa/EmissionMap.h"
 
 #include <HepPID/ParticleIDMethods.hh>
+#include <cstdio>
+#include <fstream>
 #include "gtest/gtest.h"
 
 namespace crpropa {
@@ -197,6 +203,46 @@ TEST(Candidate, property) {
 	EXPECT_EQ("bar", value);
 }
 
+TEST(Candidate, propertyKey) {
+	PropertyKey foo("foo");
+	EXPECT_TRUE(foo == PropertyKey("foo"));
+	EXPECT_TRUE(foo != PropertyKey("bar"));
+	EXPECT_EQ("foo", foo.getName());
+
+	Candidate candidate;
+	candidate.setProperty(foo, 5);
+	EXPECT_TRUE(candidate.hasProperty("foo"));
+	EXPECT_EQ(5, candidate.getProperty(foo).toInt32());
+	EXPECT_TRUE(candidate.removeProperty(foo));
+	EXPECT_FALSE(candidate.hasProperty(foo));
+	EXPECT_FALSE(candidate.removeProperty(foo));
+}
+
+TEST(Candidate, manyProperties) {
+	// more properties than the inline slots of the candidate
+	Candidate candidate;
+	for (int i = 0; i < 10; i++)
+		candidate.setProperty("p" + std::to_string(i), i);
+	EXPECT_EQ(10, candidate.properties.size());
+	candidate.removeProperty("p3");
+	EXPECT_EQ(9, candidate.properties.size());
+	EXPECT_FALSE(candidate.hasProperty("p3"));
+
+	ref_ptr<Candidate> cloned = candidate.clone();
+	for (int i = 0; i < 10; i++) {
+		if (i == 3)
+			continue;
+		EXPECT_EQ(i, cloned->getProperty("p" + std::to_string(i)).toInt32());
+	}
+
+	candidate.properties.clear();
+	EXPECT_TRUE(candidate.properties.empty());
+	candidate.setProperty("p1", 1);
+	candidate.setProperty("p2", 2);
+	candidate.removeProperty("p1");
+	EXPECT_EQ(2, candidate.getProperty("p2").toInt32());
+}
+
 TEST(Candidate, addSecondary) {
 	Candidate c;
 	c.setRedshift(5);
@@ -225,6 +271,39 @@ TEST(Candidate, serialNumber) {
 	EXPECT_EQ(43, c.getSourceSerialNumber());
 }
 
+TEST(Candidate, poolAllocation) {
+	EXPECT_TRUE(Candidate::getPoolAllocation());
+
+	// memory of a deleted candidate is reused for the next one
+	Candidate *c = new Candidate(22, 1 * EeV);
+	c->addSecondary(11, 0.5 * EeV);
+	delete c;
+	ref_ptr<Candidate> c1 = new Candidate();
+	EXPECT_EQ(c, c1.get());
+	EXPECT_EQ(0, c1->secondaries.size());
+	EXPECT_TRUE(c1->isActive());
+
+	// storage for the secondaries is reused as well
+	c1->addSecondary(11, 0.5 * EeV);
+	EXPECT_LT(0, c1->secondaries.capacity());
+	EXPECT_EQ(11, c1->secondaries[0]->current.getId());
+
+	// storage above the maximum buffer capacity is freed instead
+	Candidate *c3 = new Candidate(22, 1 * EeV);
+	for (size_t i = 0; i <= Candidate::getMaximumBufferCapacity(); i++)
+		c3->addSecondary(11, 1 * GeV);
+	delete c3;
+	ref_ptr<Candidate> c4 = new Candidate();
+	c4->addSecondary(11, 0.5 * EeV);
+	EXPECT_GE(Candidate::getMaximumBufferCapacity(), c4->secondaries.capacity());
+
+	Candidate::setPoolAllocation(false);
+	ref_ptr<Candidate> c2 = new Candidate();
+	c2->addSecondary(11, 0.5 * EeV);
+	c2 = 0;
+	Candidate::setPoolAllocation(true);
+}
+
 TEST(common, digit) {
 	EXPECT_EQ(1, digit(1234, 1000));
 	EXPECT_EQ(2, digit(1234, 100));
@@ -286,6 +365,64 @@ TEST(common, interpolateEquidistant) {
 	EXPECT_EQ(9, interpolateEquidistant(3.1, 1, 3, yD));
 }
 
+TEST(common, UniformLogTable) {
+	// logarithmic, logarithmic with leading 0, linear and irregular grids
+	std::vector<double> lg, lg0, lin, irr, Y;
+	for (int i = 0; i < 50; i++) {
+		lg.push_back(pow(10, 6 + 0.1 * i));
+		lg0.push_back(i == 0 ? 0 : 1e-4 * pow(10, i * 6. / 49));
+		lin.push_back(0.5 * i);
+		irr.push_back(i * i + i);
+		Y.push_back(sin(i));
+	}
+
+	UniformLogTable tabLg(lg, Y), tabLg0(lg0, Y), tabLin(lin, Y), tabIrr(irr, Y);
+	EXPECT_EQ(UniformLogAxis::Logarithmic, tabLg.getAxis().getSpacing());
+	EXPECT_EQ(UniformLogAxis::Logarithmic, tabLg0.getAxis().getSpacing());
+	EXPECT_EQ(UniformLogAxis::Linear, tabLin.getAxis().getSpacing());
+	EXPECT_EQ(UniformLogAxis::Irregular, tabIrr.getAxis().getSpacing());
+
+	Random random(1);
+	for (int k = 0; k < 1000; k++) {
+		double u = random.rand() * 1.2 - 0.1;
+		double x = pow(10, 6 + 4.9 * u);
+		EXPECT_DOUBLE_EQ(interpolate(x, lg, Y), tabLg.interpolate(x));
+		x = (k % 10 == 0) ? u * 1e-4 : 1e-4 * pow(10, 6 * u);
+		EXPECT_DOUBLE_EQ(interpolate(x, lg0, Y), tabLg0.interpolate(x));
+		x = 24.5 * u;
+		EXPECT_DOUBLE_EQ(interpolate(x, lin, Y), tabLin.interpolate(x));
+		x = 2450 * u;
+		EXPECT_DOUBLE_EQ(interpolate(x, irr, Y), tabIrr.interpolate(x));
+	}
+
+	// tabulation points themselves
+	for (int i = 0; i < 50; i++) {
+		EXPECT_DOUBLE_EQ(Y[i], tabLg.interpolate(lg[i]));
+		EXPECT_DOUBLE_EQ(Y[i], tabLg0.interpolate(lg0[i]));
+	}
+}
+
+TEST(common, UniformLogTable2D) {
+	std::vector<double> X, Y, Z;
+	for (int i = 0; i < 20; i++)
+		X.push_back(pow(10, 0.2 * i));
+	for (int j = 0; j < 10; j++)
+		Y.push_back(0.1 * j);
+	for (int i = 0; i < 20; i++)
+		for (int j = 0; j < 10; j++)
+			Z.push_back(i + 0.3 * j * j);
+
+	UniformLogTable2D table(X, Y, Z);
+	Random random(2);
+	for (int k = 0; k < 1000; k++) {
+		double x = pow(10, 4 * random.rand());
+		double y = 0.9 * random.rand();
+		EXPECT_DOUBLE_EQ(interpolate2d(x, y, X, Y, Z), table.interpolate(x, y));
+	}
+	EXPECT_DOUBLE_EQ(0, table.interpolate(0.5, 0.5));
+	EXPECT_DOUBLE_EQ(Z.back(), table.interpolate(X.back(), Y.back()));
+}
+
 TEST(common, pow_integer)
 {
 	EXPECT_EQ(pow_integer<0>(1.23), 1);
@@ -300,6 +437,80 @@ TEST(common, gaussInt)
 	EXPECT_NEAR(gaussInt(([](double x){ return sin(x)*sin(x); }), 0, M_PI), M_PI/2., 1e-4);
 }
 
+TEST(DataTable, textAndCache) {
+	std::ofstream out("testDataTable.txt");
+	out << "# header\n";
+	out << "1 2 3\n";
+	out << "\n";
+	out << "4.5 -1e-3 # comment\n";
+	out.close();
+	std::remove("testDataTable.txt.bin");
+
+	DataTable text("testDataTable.txt");
+	EXPECT_TRUE(text.good());
+	EXPECT_FALSE(text.isMapped());
+	EXPECT_EQ(2, text.rows());
+	EXPECT_EQ(3, text.columns(0));
+	EXPECT_EQ(2, text.columns(1));
+	EXPECT_EQ(5, text.size());
+	EXPECT_DOUBLE_EQ(3, text.get(0, 2));
+	EXPECT_DOUBLE_EQ(-1e-3, text.row(1)[1]);
+
+	DataTable::convert("testDataTable.txt");
+	DataTable cached("testDataTable.txt");
+	EXPECT_TRUE(cached.isMapped());
+	EXPECT_EQ(2, cached.rows());
+	EXPECT_EQ(2, cached.columns(1));
+	for (size_t i = 0; i < text.size(); i++)
+		EXPECT_EQ(text.data()[i], cached.data()[i]);
+
+	// the cache of a modified text file is ignored
+	out.open("testDataTable.txt", std::ios::app);
+	out << "6\n";
+	out.close();
+	DataTable modified("testDataTable.txt");
+	EXPECT_FALSE(modified.isMapped());
+	EXPECT_EQ(3, modified.rows());
+
+	DataTable missing("testDataTableMissing.txt");
+	EXPECT_FALSE(missing.good());
+	EXPECT_THROW(DataTable::convert("testDataTableMissing.txt"), std::runtime_error);
+
+	std::remove("testDataTable.txt");
+	std::remove("testDataTable.txt.bin");
+}
+
+struct TestTables: public Referenced {
+	std::vector<double> values;
+};
+
+TEST(TableRegistry, share) {
+	TableRegistry::clear();
+	ref_ptr<TestTables> a, b;
+	EXPECT_FALSE(TableRegistry::find("Test", "CMB", a));
+	a = new TestTables();
+	a->values.push_back(1);
+	TableRegistry::insert("Test", "CMB", a);
+	EXPECT_EQ(1, TableRegistry::size());
+
+	// same kind and field: shared
+	EXPECT_TRUE(TableRegistry::find("Test", "CMB", b));
+	EXPECT_TRUE(a == b);
+	ref_ptr<TestTables> c;
+	EXPECT_FALSE(TableRegistry::find("Test", "IRB", c));
+
+	// modifications detach the tables from the shared ones
+	TableRegistry::detach(b);
+	EXPECT_FALSE(a == b);
+	b->values[0] = 2;
+	EXPECT_EQ(1, a->values[0]);
+
+	// tables are released when no module uses them anymore
+	a = NULL;
+	EXPECT_EQ(0, TableRegistry::size());
+	EXPECT_FALSE(TableRegistry::find("Test", "CMB", a));
+}
+
 TEST(Random, seed) {
 	Random &a = Random::instance();
 	Random &b = Random::instance();
@@ -351,6 +562,39 @@ TEST(Random, bigSeedStorage) {
 
 }
 
+TEST(Random, counterBasedStream) {
+	Random r(42);
+	Random::setStreamSeed(0);
+	r.setStream(0);
+	EXPECT_TRUE(r.isCounterBased());
+
+	// known answer of Philox4x32-10 for counter 0 and key 0
+	EXPECT_EQ(0x6627e8d5u, r.randInt());
+	EXPECT_EQ(0xe169c58du, r.randInt());
+	EXPECT_EQ(0xbc57ac4cu, r.randInt());
+	EXPECT_EQ(0x9b00dbd8u, r.randInt());
+
+	// continue a stream at a given counter
+	Random::setStreamSeed(12345);
+	r.setStream(7);
+	std::vector<uint32_t> values;
+	for (int i = 0; i < 10; i++)
+		values.push_back(r.randInt());
+	EXPECT_EQ(10, r.getStreamCounter());
+	Random r2;
+	r2.setStream(7, 5);
+	for (int i = 5; i < 10; i++)
+		EXPECT_EQ(values[i], r2.randInt());
+
+	// other streams differ
+	r2.setStream(8);
+	EXPECT_NE(values[0], r2.randInt());
+
+	r.unsetStream();
+	EXPECT_FALSE(r.isCounterBased());
+	Random::setStreamSeed(0);
+}
+
 TEST(base64, de_en_coding)
 {
 	Random a;
@@ -393,6 +637,50 @@ TEST(Random, base64Seed) {
 	}
 }
 
+TEST(Random, aliasTable) {
+	// cdf with an empty bin and an empty distribution
+	std::vector<double> cdf;
+	cdf.push_back(1);
+	cdf.push_back(1);
+	cdf.push_back(4);
+	cdf.push_back(10);
+	AliasTable table;
+	EXPECT_EQ(0, table.add(cdf));
+	EXPECT_EQ(1, table.add(std::vector<double>(3, 0.)));
+	EXPECT_EQ(2, table.size());
+	EXPECT_EQ(4, table.bins(0));
+
+	Random random(42);
+	size_t N = 100000;
+	std::vector<size_t> count(4, 0);
+	for (size_t i = 0; i < N; i++) {
+		count[table.sample(0, random)]++;
+		EXPECT_EQ(0, table.sample(1, random));
+	}
+	EXPECT_EQ(0, count[1]);
+	EXPECT_NEAR(0.1, double(count[0]) / N, 0.005);
+	EXPECT_NEAR(0.3, double(count[2]) / N, 0.005);
+	EXPECT_NEAR(0.6, double(count[3]) / N, 0.005);
+}
+
+TEST(Random, randNormArray) {
+	// odd number of values: the last one is drawn with randNorm
+	Random random(42);
+	size_t N = 100001;
+	std::vector<double> x(N);
+	random.randNormArray(&x[0], N);
+	double mean = 0, var = 0, corr = 0;
+	for (size_t i = 0; i < N; i++) {
+		mean += x[i] / N;
+		var += x[i] * x[i] / N;
+		if (i % 2 == 1)
+			corr += x[i] * x[i - 1] / (N / 2);
+	}
+	EXPECT_NEAR(0, mean, 0.01);
+	EXPECT_NEAR(1, var, 0.02);
+	EXPECT_NEAR(0, corr, 0.02); // the two numbers of a pair are independent
+}
+
 
 
 TEST(Grid, PeriodicClamp) {
@@ -1,5 +1,6 @@
 #include "crpropa/Candidate.h"
 #include "crpropa/Units.h"
+#include "crpropa/Cosmology.h"
 #include "crpropa/ParticleID.h"
 #include "crpropa/PhotonBackground.h"
 #include "crpropa/module/ElectronPairProduction.h"
@@ -12,8 +13,13 @@
 #include "crpropa/module/EMDoublePairProduction.h"
 #include "crpropa/module/EMTripletPairProduction.h"
 #include "crpropa/module/EMInverseComptonScattering.h"
+#include "crpropa/module/EMCascade.h"
+#include "crpropa/module/CompetingInteractions.h"
+#include "crpropa/module/SimplePropagation.h"
+#include "crpropa/module/SynchrotronRadiation.h"
 #include "gtest/gtest.h"
 
+#include <cstdio>
 #include <fstream>
 
 namespace crpropa {
@@ -84,6 +90,27 @@ TEST(ElectronPairProduction, thisIsNotNucleonic) {
 	EXPECT_DOUBLE_EQ(1E20 * eV, c.current.getEnergy());
 }
 
+TEST(ElectronPairProduction, thinning) {
+	// Test if thinning reduces the number of pairs and conserves the weighted energy on average.
+	// This test can stochastically fail.
+	ref_ptr<PhotonField> CMB_instance = new CMB();
+	ElectronPairProduction epp(CMB_instance, true);
+	epp.setThinning(1);
+	double dE = 0, Esecondaries = 0;
+	size_t nSecondaries = 0, N = 1000;
+	for (size_t i = 0; i < N; i++) {
+		Candidate c(nucleusId(1, 1), 1E20 * eV);
+		c.setCurrentStep(10 * Mpc);
+		epp.process(&c);
+		dE += 1E20 * eV - c.current.getEnergy();
+		nSecondaries += c.secondaries.size();
+		for (size_t j = 0; j < c.secondaries.size(); j++)
+			Esecondaries += c.secondaries[j]->current.getEnergy() * c.secondaries[j]->getWeight();
+	}
+	EXPECT_LT(nSecondaries, 10 * N);
+	EXPECT_NEAR(1, Esecondaries / dE, 0.1);
+}
+
 TEST(ElectronPairProduction, valuesCMB) {
 	// Test if energy loss corresponds to the data table.
 	std::vector<double> x;
@@ -206,6 +233,19 @@ TEST(NuclearDecay, helium5) {
 	EXPECT_EQ(1, c2.current.getEnergy() / EeV);
 }
 
+TEST(NuclearDecay, instantDecay) {
+	// Test if the decay chain of He-5 is resolved without limiting the step.
+	NuclearDecay d;
+	d.setInstantDecay(1e-3);
+	Candidate c(nucleusId(5, 2), 5 * EeV);
+	c.setCurrentStep(1 * kpc);
+	c.setNextStep(std::numeric_limits<double>::max());
+	d.process(&c);
+	EXPECT_EQ(nucleusId(4, 2), c.current.getId());
+	EXPECT_EQ(1, c.secondaries.size());
+	EXPECT_EQ(std::numeric_limits<double>::max(), c.getNextStep());
+}
+
 TEST(NuclearDecay, limitNextStep) {
 	// Test if next step is limited in case of a neutron.
 	NuclearDecay decay;
@@ -576,6 +616,51 @@ TEST(PhotoPionProduction, secondaries) {
 	EXPECT_GT(c.secondaries.size(), 1);
 }
 
+TEST(PhotoPionProduction, eventLibrary) {
+	// Test sampling of tabulated SOPHIA events.
+	PhotoPionEventLibrary library(5, 2);
+	Random random(42);
+	size_t first, last;
+	EXPECT_FALSE(library.sample(true, 100 * EeV, 1e-12 * eV, random, first, last));
+	EXPECT_FALSE(library.sample(true, 100 * EeV, 1e6 * eV, random, first, last));
+
+	// E_in * eps = 1 GeV^2, above the pion production threshold
+	for (int i = 0; i < 10; i++) {
+		EXPECT_TRUE(library.sample(i % 2, 100 * EeV, 1e-2 * eV, random, first, last));
+		EXPECT_GT(last, first + 1);
+		double sum = 0;
+		for (size_t j = first; j < last; j++)
+			sum += library.getEnergyFraction(j);
+		EXPECT_NEAR(1, sum, 1e-3); // energy conservation
+	}
+
+	// E_in * eps = 0.072 GeV^2, just above the threshold: no empty events
+	for (int i = 0; i < 10; i++) {
+		EXPECT_TRUE(library.sample(i % 2, 100 * EeV, 0.72e-3 * eV, random, first, last));
+		EXPECT_GT(last, first + 1);
+	}
+}
+
+TEST(PhotoPionProduction, tabulatedPhotonSampling) {
+	// Test if the tabulated photon energies follow the rejection sampling.
+	PhotonFieldSampling rejection(1), tabulated(1);
+	tabulated.initTable(10.5, 11.5, 10, 1, 3);
+	EXPECT_TRUE(tabulated.hasTable());
+	double E = 1e11; // GeV
+	double epsMin = 0.28 / 4 / E * 1e9 * eV; // below threshold
+	double epsMax = 0.007 * 2.73 * eV;
+	size_t N = 5000;
+	double mean1 = 0, mean2 = 0;
+	for (size_t i = 0; i < N; i++) {
+		double eps = tabulated.sample_eps(true, E, 0.5);
+		EXPECT_GE(eps, epsMin);
+		EXPECT_LE(eps, epsMax * 1.5);
+		mean1 += std::log(rejection.sample_eps(true, E, 0) / eV) / N;
+		mean2 += std::log(tabulated.sample_eps(true, E, 0) / eV) / N;
+	}
+	EXPECT_NEAR(mean1, mean2, 0.03);
+}
+
 // Redshift -------------------------------------------------------------------
 TEST(Redshift, simpleTest) {
 	// Test if redshift is decreased and adiabatic energy loss is applied.
@@ -603,6 +688,28 @@ TEST(Redshift, limitRedshiftDecrease) {
 	EXPECT_DOUBLE_EQ(0, c.getRedshift());
 }
 
+TEST(Redshift, largeStep) {
+	// Test if a single large step ends at the same redshift as many small ones.
+	Redshift redshift;
+
+	Candidate c1, c2;
+	c1.setRedshift(1);
+	c1.current.setEnergy(100 * EeV);
+	c1.setCurrentStep(2 * Gpc);
+	redshift.process(&c1);
+
+	c2.setRedshift(1);
+	c2.current.setEnergy(100 * EeV);
+	c2.setCurrentStep(0.1 * Mpc);
+	for (int i = 0; i < 20000; i++)
+		redshift.process(&c2);
+
+	double z = comovingDistance2Redshift(redshift2ComovingDistance(1) - 2 * Gpc);
+	EXPECT_NEAR(z, c1.getRedshift(), 1e-6);
+	EXPECT_NEAR(c2.getRedshift(), c1.getRedshift(), 1e-3);
+	EXPECT_NEAR((1 + z) / 2 * 100, c1.current.getEnergy() / EeV, 1e-4);
+}
+
 // EMPairProduction -----------------------------------------------------------
 TEST(EMPairProduction, allBackgrounds) {
 	// Test if interaction data files are loaded.
@@ -949,6 +1056,163 @@ TEST(EMInverseComptonScattering, secondaries) {
 	}
 }
 
+// EMCascade ------------------------------------------------------------------
+TEST(EMCascade, maximumEnergy) {
+	// Test if only particles below the maximum energy are collected, weighted.
+	EMCascade cascade;
+	cascade.setDistanceBinning(10 * Mpc, 10);
+	cascade.setMaximumEnergy(1 * PeV);
+
+	Candidate c(22, 10 * PeV, Vector3d(5.5 * Mpc, 0, 0));
+	cascade.process(&c);
+	EXPECT_TRUE(c.isActive());
+
+	size_t N = 1000;
+#pragma omp parallel for
+	for (size_t i = 0; i < N; i++) {
+		Candidate c(11, 100 * TeV, Vector3d(5.5 * Mpc, 0, 0));
+		c.setWeight(2);
+		cascade.process(&c);
+		EXPECT_FALSE(c.isActive());
+	}
+
+	std::string filename = "EMCascade_maximumEnergy.txt";
+	cascade.save(filename);
+	std::ifstream infile(filename.c_str());
+	infile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+	double D, logE, photons, electrons, positrons;
+	double sumPhotons = 0, sumElectrons = 0;
+	while (infile >> D >> logE >> photons >> electrons >> positrons) {
+		sumPhotons += photons;
+		sumElectrons += electrons;
+		if (electrons > 0) {
+			EXPECT_DOUBLE_EQ(5.5, D);
+			EXPECT_NEAR(14, logE, 0.1);
+		}
+	}
+	infile.close();
+	std::remove(filename.c_str());
+	EXPECT_EQ(0, sumPhotons);
+	EXPECT_EQ(2 * N, sumElectrons);
+}
+
+// SynchrotronRadiation -------------------------------------------------------
+TEST(SynchrotronRadiation, aggregatePhotons) {
+	// Test if the aggregate photons carry exactly the energy loss.
+	SynchrotronRadiation sync(1 * muG, true);
+	sync.setSecondaryThreshold(0);
+	sync.setAggregatePhotons(5);
+	Candidate c(11, 1 * PeV);
+	c.setCurrentStep(1 * pc);
+	sync.process(&c);
+	EXPECT_EQ(5, c.secondaries.size());
+	double Esecondaries = 0;
+	for (size_t i = 0; i < c.secondaries.size(); i++)
+		Esecondaries += c.secondaries[i]->current.getEnergy() * c.secondaries[i]->getWeight();
+	EXPECT_NEAR(1 * PeV - c.current.getEnergy(), Esecondaries, 1e-9 * Esecondaries);
+}
+
+TEST(SynchrotronRadiation, drawPhotons) {
+	// Test if the drawn photons sum up to the energy loss.
+	SynchrotronRadiation sync(1 * muG, true);
+	std::vector<double> energies;
+	double dE = 1 * TeV;
+	double rest = sync.drawPhotons(1 * GeV, dE, energies, Random::instance());
+	EXPECT_GT(energies.size(), 100);
+	double Etotal = 0;
+	for (size_t i = 0; i < energies.size(); i++)
+		Etotal += energies[i];
+	EXPECT_NEAR(dE, Etotal + rest, 1e-9 * dE);
+	EXPECT_LT(rest, 100 * GeV);
+}
+
+// CompetingInteractions ------------------------------------------------------
+class ConstantInteraction: public AbstractInteraction {
+public:
+	double rate;
+	unsigned int classes;
+	mutable size_t calls;
+	ConstantInteraction(double rate, unsigned int classes = ParticleClassAll) :
+			rate(rate), classes(classes), calls(0) {
+	}
+	double interactionRate(const Candidate *) const {
+		return rate;
+	}
+	void interact(Candidate *candidate) const {
+		calls++;
+		candidate->setActive(false);
+	}
+	void process(Candidate *) const {
+	}
+	unsigned int getParticleClasses() const {
+		return classes;
+	}
+};
+
+TEST(CompetingInteractions, selection) {
+	// Test if the interactions are selected in proportion to their rates.
+	ref_ptr<ConstantInteraction> a = new ConstantInteraction(1 / Mpc);
+	ref_ptr<ConstantInteraction> b = new ConstantInteraction(3 / Mpc);
+	ref_ptr<ConstantInteraction> c = new ConstantInteraction(100 / Mpc, ParticleClassPhoton);
+	CompetingInteractions ci;
+	ci.add(a);
+	ci.add(b);
+	ci.add(c);
+	EXPECT_EQ(3, ci.size());
+	EXPECT_EQ(ParticleClassAll, ci.getParticleClasses());
+
+	size_t N = 10000;
+	for (size_t i = 0; i < N; i++) {
+		Candidate p(nucleusId(1, 1), 1 * EeV);
+		p.setCurrentStep(100 * Mpc);
+		ci.process(&p);
+		EXPECT_FALSE(p.isActive());
+	}
+	EXPECT_EQ(N, a->calls + b->calls);
+	EXPECT_EQ(0, c->calls); // only acting on photons
+	EXPECT_NEAR(0.25, double(a->calls) / N, 0.02);
+}
+
+TEST(CompetingInteractions, limitNextStep) {
+	// Test if the next step is limited by the total rate.
+	CompetingInteractions ci(0.1);
+	ci.add(new ConstantInteraction(1 / Mpc));
+	ci.add(new ConstantInteraction(3 / Mpc));
+	Candidate p(nucleusId(1, 1), 1 * EeV);
+	p.setCurrentStep(0);
+	p.setNextStep(std::numeric_limits<double>::max());
+	ci.process(&p);
+	EXPECT_TRUE(p.isActive());
+	EXPECT_DOUBLE_EQ(0.1 / 4 * Mpc, p.getNextStep());
+}
+
+
+TEST(CompetingInteractions, eventDriven) {
+	// Test if photons jump to their interactions, which are exponentially distributed.
+	CompetingInteractions ci;
+	ci.add(new ConstantInteraction(1 / Mpc));
+	ci.add(new ConstantInteraction(3 / Mpc));
+	ci.setEventDriven(true);
+	EXPECT_TRUE(ci.isEventDriven());
+	SimplePropagation propa(0, 10 * kpc);
+	propa.setEventDrivenNeutrals(true);
+
+	size_t N = 10000;
+	size_t steps = 0;
+	double length = 0;
+	for (size_t i = 0; i < N; i++) {
+		Candidate c(22, 1 * EeV);
+		while (c.isActive()) {
+			propa.process(&c);
+			ci.process(&c);
+			steps++;
+		}
+		length += c.current.getPosition().getR();
+	}
+	// one step to limit the next step, one to the interaction
+	EXPECT_EQ(2 * N, steps);
+	EXPECT_NEAR(0.25 * Mpc, length / N, 0.01 * Mpc);
+}
 
 int main(int argc, char **argv) {
 	::testing::InitGoogleTest(&argc, argv);
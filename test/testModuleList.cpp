@@ -1,6 +1,7 @@
 #include "crpropa/ModuleList.h"
 #include "crpropa/Source.h"
 #include "crpropa/ParticleID.h"
+#include "crpropa/Random.h"
 #include "crpropa/module/SimplePropagation.h"
 #include "crpropa/module/BreakCondition.h"
 
@@ -8,6 +9,25 @@
 
 namespace crpropa {
 
+// splits each candidate above 1 EeV into two halves and counts the leaves
+class TestCascadeSplitting: public Module {
+public:
+	mutable size_t nLeaves;
+	TestCascadeSplitting() : nLeaves(0) {
+	}
+	void process(Candidate *candidate) const {
+		double E = candidate->current.getEnergy();
+		if (E > 1 * EeV) {
+			candidate->addSecondary(22, E / 2);
+			candidate->addSecondary(22, E / 2);
+		} else {
+#pragma omp atomic
+			nLeaves++;
+		}
+		candidate->setActive(false);
+	}
+};
+
 TEST(ModuleList, process) {
 	ModuleList modules;
 	modules.add(new SimplePropagation());
@@ -31,6 +51,90 @@ TEST(ModuleList, removeModule) {
 	EXPECT_EQ(modules.size(), 0);
 }
 
+// counts the calls and optionally turns the particle into another species
+class TestSpeciesModule: public Module {
+public:
+	unsigned int classes;
+	int newId;
+	mutable int nCalls;
+	TestSpeciesModule(unsigned int classes, int newId = 0) :
+			classes(classes), newId(newId), nCalls(0) {
+	}
+	void process(Candidate *candidate) const {
+		nCalls++;
+		if (newId != 0)
+			candidate->current.setId(newId);
+	}
+	unsigned int getParticleClasses() const {
+		return classes;
+	}
+};
+
+TEST(ModuleList, particleClass) {
+	EXPECT_EQ(ParticleClassPhoton, particleClass(22));
+	EXPECT_EQ(ParticleClassElectron, particleClass(-11));
+	EXPECT_EQ(ParticleClassNeutrino, particleClass(14));
+	EXPECT_EQ(ParticleClassNucleus, particleClass(nucleusId(56, 26)));
+	EXPECT_EQ(ParticleClassNucleus, particleClass(2112));
+	EXPECT_EQ(ParticleClassOther, particleClass(13));
+}
+
+TEST(ModuleList, speciesDispatch) {
+	ModuleList modules;
+	ref_ptr<TestSpeciesModule> nuclei = new TestSpeciesModule(ParticleClassNucleus);
+	ref_ptr<TestSpeciesModule> all = new TestSpeciesModule(ParticleClassAll);
+	ref_ptr<TestSpeciesModule> convert = new TestSpeciesModule(ParticleClassPhoton, 11);
+	ref_ptr<TestSpeciesModule> electrons = new TestSpeciesModule(ParticleClassElectron);
+	modules.add(nuclei);
+	modules.add(all);
+	modules.add(convert);
+	modules.add(electrons);
+
+	// a nucleus is not passed to the photon and electron modules
+	ref_ptr<Candidate> c = new Candidate(nucleusId(1, 1), 1 * EeV);
+	modules.process(c);
+	EXPECT_EQ(1, nuclei->nCalls);
+	EXPECT_EQ(1, all->nCalls);
+	EXPECT_EQ(0, convert->nCalls);
+	EXPECT_EQ(0, electrons->nCalls);
+
+	// a photon turned into an electron reaches the electron module
+	c = new Candidate(22, 1 * EeV);
+	modules.process(c);
+	EXPECT_EQ(1, nuclei->nCalls);
+	EXPECT_EQ(2, all->nCalls);
+	EXPECT_EQ(1, convert->nCalls);
+	EXPECT_EQ(1, electrons->nCalls);
+
+	// removed modules are not called anymore
+	modules.remove(1);
+	c = new Candidate(11, 1 * EeV);
+	modules.process(c);
+	EXPECT_EQ(2, all->nCalls);
+	EXPECT_EQ(2, electrons->nCalls);
+}
+
+TEST(ModuleList, speciesDispatchBatch) {
+	ModuleList modules;
+	ref_ptr<TestSpeciesModule> nuclei = new TestSpeciesModule(ParticleClassNucleus);
+	ref_ptr<TestSpeciesModule> convert = new TestSpeciesModule(ParticleClassPhoton, 11);
+	ref_ptr<TestSpeciesModule> electrons = new TestSpeciesModule(ParticleClassElectron);
+	modules.add(nuclei);
+	modules.add(convert);
+	modules.add(electrons);
+
+	// each module only gets the candidates of its species
+	ref_ptr<Candidate> c[3];
+	c[0] = new Candidate(nucleusId(1, 1), 1 * EeV);
+	c[1] = new Candidate(22, 1 * EeV);
+	c[2] = new Candidate(nucleusId(4, 2), 1 * EeV);
+	Candidate *batch[3] = {c[0], c[1], c[2]};
+	modules.processBatch(batch, 3);
+	EXPECT_EQ(2, nuclei->nCalls);
+	EXPECT_EQ(1, convert->nCalls);
+	EXPECT_EQ(1, electrons->nCalls); // the photon turned into an electron
+}
+
 TEST(ModuleList, runCandidateList) {
 	ModuleList modules;
 	modules.add(new SimplePropagation());
@@ -55,6 +159,228 @@ TEST(ModuleList, runSource) {
 	modules.run(&source, 100, false);
 }
 
+TEST(ModuleList, runSecondariesAsTasks) {
+	ModuleList modules;
+	ref_ptr<TestCascadeSplitting> splitting = new TestCascadeSplitting();
+	modules.add(splitting);
+	modules.setSecondariesAsTasks();
+	EXPECT_TRUE(modules.getSecondariesAsTasks());
+
+	ModuleList::candidate_vector_t candidates;
+	for (int i = 0; i < 4; i++)
+		candidates.push_back(new Candidate(22, 1024 * EeV));
+
+	modules.run(&candidates, true, false);
+	EXPECT_EQ(4 * 1024, splitting->nLeaves);
+
+	splitting->nLeaves = 0;
+	for (int i = 0; i < 4; i++)
+		candidates[i] = new Candidate(22, 1024 * EeV);
+	modules.run(&candidates, true, true);
+	EXPECT_EQ(4 * 1024, splitting->nLeaves);
+}
+
+TEST(ModuleList, releaseSecondaries) {
+	ModuleList modules;
+	ref_ptr<TestCascadeSplitting> splitting = new TestCascadeSplitting();
+	modules.add(splitting);
+	modules.setReleaseSecondaries();
+	EXPECT_TRUE(modules.getReleaseSecondaries());
+
+	ref_ptr<Candidate> candidate = new Candidate(22, 1024 * EeV);
+	modules.run(candidate);
+	EXPECT_EQ(1024, splitting->nLeaves);
+	EXPECT_EQ(0, candidate->secondaries.size());
+
+	splitting->nLeaves = 0;
+	candidate = new Candidate(22, 1024 * EeV);
+	modules.run(candidate, true, true);
+	EXPECT_EQ(1024, splitting->nLeaves);
+	EXPECT_EQ(0, candidate->secondaries.size());
+
+	splitting->nLeaves = 0;
+	modules.setSecondariesAsTasks();
+	ModuleList::candidate_vector_t candidates;
+	candidates.push_back(new Candidate(22, 1024 * EeV));
+	modules.run(&candidates);
+	EXPECT_EQ(1024, splitting->nLeaves);
+	EXPECT_EQ(0, candidates[0]->secondaries.size());
+}
+
+// emits many secondaries at once, which count the finished siblings still held by the parent
+class TestWideCascade: public Module {
+public:
+	mutable size_t maxFinishedSiblings;
+	TestWideCascade() : maxFinishedSiblings(0) {
+	}
+	void process(Candidate *candidate) const {
+		if (candidate->parent == 0) {
+			for (int i = 0; i < 100; i++)
+				candidate->addSecondary(22, 1 * EeV);
+		} else {
+			const std::vector<ref_ptr<Candidate> > &siblings = candidate->parent->secondaries;
+			size_t n = 0;
+			for (size_t i = 0; (i < siblings.size()) && (siblings[i] != candidate); i++)
+				if (siblings[i].valid())
+					n++;
+#pragma omp critical(TestWideCascade)
+			maxFinishedSiblings = std::max(maxFinishedSiblings, n);
+		}
+		candidate->setActive(false);
+	}
+};
+
+TEST(ModuleList, releaseEachSecondary) {
+	ModuleList modules;
+	ref_ptr<TestWideCascade> cascade = new TestWideCascade();
+	modules.add(cascade);
+
+	ref_ptr<Candidate> candidate = new Candidate(22, 100 * EeV);
+	modules.run(candidate, true, false);
+	EXPECT_EQ(99, cascade->maxFinishedSiblings);
+
+	// each secondary is released as soon as it is finished
+	modules.setReleaseSecondaries();
+	cascade->maxFinishedSiblings = 0;
+	candidate = new Candidate(22, 100 * EeV);
+	modules.run(candidate, true, false);
+	EXPECT_EQ(0, cascade->maxFinishedSiblings);
+	EXPECT_EQ(0, candidate->secondaries.size());
+}
+
+// splits a candidate at a random fraction and sums up random numbers of the leaves
+class TestRandomCascade: public Module {
+public:
+	mutable uint64_t checksum;
+	TestRandomCascade() : checksum(0) {
+	}
+	void process(Candidate *candidate) const {
+		Random &random = Random::instance();
+		double E = candidate->current.getEnergy();
+		if (E > 1 * EeV) {
+			double f = random.randUniform(0.2, 0.8);
+			candidate->addSecondary(22, E * f);
+			candidate->addSecondary(22, E * (1 - f));
+		} else {
+			uint64_t r = random.randInt();
+#pragma omp atomic
+			checksum += r;
+		}
+		candidate->setActive(false);
+	}
+};
+
+uint64_t runRandomCascade(ModuleList &modules, TestRandomCascade *cascade) {
+	cascade->checksum = 0;
+	ModuleList::candidate_vector_t candidates;
+	for (int i = 0; i < 8; i++)
+		candidates.push_back(new Candidate(22, 100 * EeV));
+	modules.run(&candidates);
+	return cascade->checksum;
+}
+
+TEST(ModuleList, counterBasedRandom) {
+	ModuleList modules;
+	ref_ptr<TestRandomCascade> cascade = new TestRandomCascade();
+	modules.add(cascade);
+	modules.setCounterBasedRandom();
+	EXPECT_TRUE(modules.getCounterBasedRandom());
+
+	Random::seedThreads(1);
+	uint64_t checksum = runRandomCascade(modules, cascade);
+	EXPECT_NE(0, checksum);
+
+	// independent of the state of the thread generators and of the scheduling
+	Random::seedThreads(2);
+	EXPECT_EQ(checksum, runRandomCascade(modules, cascade));
+	modules.setSecondariesAsTasks();
+	EXPECT_EQ(checksum, runRandomCascade(modules, cascade));
+
+	// the stream seed changes the results
+	Random::setStreamSeed(1);
+	EXPECT_NE(checksum, runRandomCascade(modules, cascade));
+	Random::setStreamSeed(0);
+
+	// the thread generator is unaffected after the run
+	EXPECT_FALSE(Random::instance().isCounterBased());
+}
+
+// emits one secondary per step of the primary, the secondaries record a random number
+class TestRandomEmission: public Module {
+public:
+	mutable std::vector<uint32_t> values;
+	void process(Candidate *candidate) const {
+		if (candidate->current.getId() == 22) {
+			candidate->addSecondary(11, 1 * EeV);
+			if (candidate->getTrajectoryLength() >= 9)
+				candidate->setActive(false);
+			candidate->setTrajectoryLength(candidate->getTrajectoryLength() + 1);
+		} else {
+			values.push_back(Random::instance().randInt());
+			candidate->setActive(false);
+		}
+	}
+};
+
+TEST(ModuleList, counterBasedRandomReleaseSecondaries) {
+	ModuleList modules;
+	ref_ptr<TestRandomEmission> emission = new TestRandomEmission();
+	modules.add(emission);
+	modules.setCounterBasedRandom();
+
+	ref_ptr<Candidate> candidate = new Candidate(22, 100 * EeV);
+	modules.run(candidate, true, true);
+	std::vector<uint32_t> values = emission->values;
+	EXPECT_EQ(10, values.size());
+	EXPECT_EQ(10, candidate->secondaries.size());
+
+	// released secondaries do not hand their streams on to later ones
+	modules.setReleaseSecondaries();
+	emission->values.clear();
+	candidate = new Candidate(22, 100 * EeV);
+	modules.run(candidate, true, true);
+	EXPECT_EQ(0, candidate->secondaries.size());
+	EXPECT_TRUE(values == emission->values);
+	std::sort(values.begin(), values.end());
+	EXPECT_TRUE(std::unique(values.begin(), values.end()) == values.end());
+}
+
+TEST(ModuleList, runBatched) {
+	ModuleList modules;
+	modules.add(new SimplePropagation(1 * kpc, 1 * Mpc));
+	modules.add(new MaximumTrajectoryLength(10 * Mpc));
+
+	ModuleList::candidate_vector_t candidates;
+	for (int i = 0; i < 10; i++)
+		candidates.push_back(new Candidate(22, 1 * EeV));
+
+	modules.runBatched(&candidates, 3);
+	for (int i = 0; i < 10; i++) {
+		EXPECT_DOUBLE_EQ(10 * Mpc, candidates[i]->getTrajectoryLength());
+		EXPECT_FALSE(candidates[i]->isActive());
+	}
+}
+
+TEST(ModuleList, runBatchedSecondaries) {
+	ModuleList modules;
+	ref_ptr<TestCascadeSplitting> splitting = new TestCascadeSplitting();
+	modules.add(splitting);
+
+	ModuleList::candidate_vector_t candidates;
+	for (int i = 0; i < 5; i++)
+		candidates.push_back(new Candidate(22, 256 * EeV));
+
+	modules.runBatched(&candidates, 2);
+	EXPECT_EQ(5 * 256, splitting->nLeaves);
+
+	// without recursion only the primaries are processed
+	splitting->nLeaves = 0;
+	for (int i = 0; i < 5; i++)
+		candidates[i] = new Candidate(22, 1 * EeV);
+	modules.runBatched(&candidates, 2, false);
+	EXPECT_EQ(5, splitting->nLeaves);
+}
+
 #if _OPENMP
 #include <omp.h>
 TEST(ModuleList, runOpenMP) {
@@ -3,9 +3,13 @@
 #include "crpropa/module/SimplePropagation.h"
 #include "crpropa/module/PropagationBP.h"
 #include "crpropa/module/PropagationCK.h"
+#include "crpropa/module/PropagationDP.h"
+#include "crpropa/module/PropagationGuidingCenter.h"
+#include "crpropa/module/DiffusionSDE.h"
 
 #include "gtest/gtest.h"
 
+#include <limits>
 #include <string>
 #include <iostream>
 
@@ -99,6 +103,331 @@ TEST(testPropagationCK, neutron) {
 }
 
 
+TEST(testPropagationCK, eventDrivenNeutrals) {
+	// Neutral particles are not limited by the maximum step in the event-driven mode.
+	PropagationCK propa(new UniformMagneticField(Vector3d(0, 0, 1 * nG)));
+	propa.setMaximumStep(42 * Mpc);
+	propa.setEventDrivenNeutrals(true);
+	EXPECT_TRUE(propa.isEventDrivenNeutrals());
+
+	ParticleState p;
+	p.setId(nucleusId(1, 0));
+	p.setEnergy(100 * EeV);
+	p.setPosition(Vector3d(0, 0, 0));
+	p.setDirection(Vector3d(0, 1, 0));
+	Candidate c(p);
+	c.setNextStep(5 * Gpc);
+
+	propa.process(&c);
+
+	EXPECT_DOUBLE_EQ(5 * Gpc, c.getCurrentStep());
+	EXPECT_DOUBLE_EQ(std::numeric_limits<double>::max(), c.getNextStep());
+	EXPECT_EQ(Vector3d(0, 5 * Gpc, 0), c.current.getPosition());
+
+	// charged particles keep the maximum step
+	p.setId(nucleusId(1, 1));
+	Candidate d(p);
+	d.setNextStep(5 * Gpc);
+	propa.process(&d);
+	EXPECT_GE(42 * Mpc, d.getCurrentStep());
+	EXPECT_GE(42 * Mpc, d.getNextStep());
+}
+
+
+TEST(testPropagationCK, processBatch) {
+	// Test if the batch integration gives the same steps as the single candidate one.
+	PropagationCK propa(new UniformMagneticField(Vector3d(0, 0.3 * muG, 1 * muG)));
+	propa.setMinimumStep(1 * pc);
+	propa.setMaximumStep(1 * Mpc);
+
+	std::vector<ref_ptr<Candidate> > single, batch;
+	std::vector<Candidate *> pointers;
+	for (size_t i = 0; i < 11; i++) {
+		int id = (i == 5) ? nucleusId(1, 0) : ((i % 3 == 0) ? nucleusId(56, 26) : nucleusId(1, 1));
+		ParticleState p;
+		p.setId(id);
+		p.setEnergy(pow(10, 17 + 0.3 * i) * eV);
+		p.setPosition(Vector3d(i * kpc, 0, 0));
+		p.setDirection(Vector3d(1, 0.1 * i, 0));
+		Candidate *c = new Candidate(p);
+		c->setNextStep((i + 1) * 10 * kpc);
+		single.push_back(c);
+		batch.push_back(c->clone());
+		pointers.push_back(batch.back());
+	}
+
+	for (size_t step = 0; step < 3; step++) {
+		for (size_t i = 0; i < single.size(); i++)
+			propa.process(single[i]);
+		propa.processBatch(&pointers[0], pointers.size());
+	}
+
+	for (size_t i = 0; i < single.size(); i++) {
+		double step = single[i]->getCurrentStep();
+		EXPECT_NEAR(step, batch[i]->getCurrentStep(), 1e-9 * step);
+		EXPECT_NEAR(single[i]->getNextStep(), batch[i]->getNextStep(), 1e-9 * single[i]->getNextStep());
+		Vector3d dx = single[i]->current.getPosition() - batch[i]->current.getPosition();
+		EXPECT_LT(dx.getR(), 1e-9 * single[i]->current.getPosition().getR());
+		Vector3d du = single[i]->current.getDirection() - batch[i]->current.getDirection();
+		EXPECT_LT(du.getR(), 1e-9);
+		EXPECT_EQ(single[i]->previous.getPosition(), batch[i]->previous.getPosition());
+	}
+}
+
+TEST(testPropagationDP, zeroField) {
+	PropagationDP propa(new UniformMagneticField(Vector3d(0, 0, 0)));
+
+	double minStep = 0.1 * kpc;
+	propa.setMinimumStep(minStep);
+
+	ParticleState p;
+	p.setId(nucleusId(1, 1));
+	p.setEnergy(100 * EeV);
+	p.setPosition(Vector3d(0, 0, 0));
+	p.setDirection(Vector3d(0, 1, 0));
+	Candidate c(p);
+	c.setNextStep(0);
+
+	propa.process(&c);
+
+	EXPECT_DOUBLE_EQ(minStep, c.getCurrentStep());  // perform minimum step
+	EXPECT_DOUBLE_EQ(5 * minStep, c.getNextStep());  // acceleration by factor 5
+}
+
+
+TEST(testPropagationDP, neutron) {
+	PropagationDP propa(new UniformMagneticField(Vector3d(0, 0, 1 * nG)));
+	propa.setMinimumStep(1 * kpc);
+	propa.setMaximumStep(42 * Mpc);
+
+	ParticleState p;
+	p.setId(nucleusId(1, 0));
+	p.setEnergy(100 * EeV);
+	p.setPosition(Vector3d(0, 0, 0));
+	p.setDirection(Vector3d(0, 1, 0));
+	Candidate c(p);
+
+	propa.process(&c);
+
+	EXPECT_DOUBLE_EQ(1 * kpc, c.getCurrentStep());
+	EXPECT_DOUBLE_EQ(42 * Mpc, c.getNextStep());
+	EXPECT_EQ(Vector3d(0, 1 * kpc, 0), c.current.getPosition());
+	EXPECT_EQ(Vector3d(0, 1, 0), c.current.getDirection());
+}
+
+
+TEST(testPropagationDP, gyration) {
+	// Test if a proton stays on its gyration circle in a uniform field.
+	double B = 1 * nG;
+	double E = 10 * EeV;
+	PropagationDP propa(new UniformMagneticField(Vector3d(0, 0, B)), 1e-6);
+	propa.setMinimumStep(1 * pc);
+	propa.setMaximumStep(1 * Mpc);
+
+	ParticleState p;
+	p.setId(nucleusId(1, 1));
+	p.setEnergy(E);
+	p.setPosition(Vector3d(0, 0, 0));
+	p.setDirection(Vector3d(1, 0, 0));
+	Candidate c(p);
+	c.setNextStep(10 * kpc);
+
+	double rg = E / (eplus * c_light * B);
+	Vector3d center(0, -rg, 0);  // force along v x B = -y
+	while (c.getTrajectoryLength() < 3 * rg) {
+		propa.process(&c);
+		c.setTrajectoryLength(c.getTrajectoryLength() + c.getCurrentStep());
+	}
+	double r = (c.current.getPosition() - center).getR();
+	EXPECT_NEAR(rg, r, 1e-4 * rg);
+	EXPECT_NEAR(1, c.current.getDirection().getR(), 1e-12);
+}
+
+
+class CountingMagneticField: public MagneticField {
+public:
+	mutable int calls;
+	CountingMagneticField() : calls(0) {
+	}
+	Vector3d getField(const Vector3d &position) const {
+		calls++;
+		return Vector3d(0, 0, 1 * nG);
+	}
+};
+
+TEST(testPropagationDP, firstSameAsLast) {
+	// The field at the end of a step is reused for the first stage of the next step.
+	ref_ptr<CountingMagneticField> field = new CountingMagneticField();
+	PropagationDP propa(field, 1);
+	propa.setMinimumStep(1 * kpc);
+	propa.setMaximumStep(1 * kpc);
+
+	ParticleState p;
+	p.setId(nucleusId(1, 1));
+	p.setEnergy(100 * EeV);
+	p.setDirection(Vector3d(1, 0, 0));
+	Candidate c(p);
+
+	propa.process(&c);
+	EXPECT_EQ(7, field->calls);
+	propa.process(&c);
+	EXPECT_EQ(13, field->calls);
+
+	// moving the candidate invalidates the cached field
+	c.current.setPosition(Vector3d(0, 0, 0));
+	propa.process(&c);
+	EXPECT_EQ(20, field->calls);
+}
+
+TEST(testPropagationGuidingCenter, helix) {
+	// In a uniform field the guiding center moves along the field line with the maximum step.
+	double B = 1 * muG;
+	PropagationGuidingCenter propa(new UniformMagneticField(Vector3d(0, 0, B)));
+	propa.setMaximumStep(1 * kpc);
+
+	ParticleState p;
+	p.setId(nucleusId(1, 1));
+	p.setEnergy(1e15 * eV);
+	p.setPosition(Vector3d(0, 0, 0));
+	p.setDirection(Vector3d(0.6, 0, 0.8));
+	Candidate c(p);
+	c.setNextStep(1 * Gpc);
+
+	propa.process(&c);
+
+	double rg = p.getEnergy() / (eplus * c_light * B);
+	Vector3d center(0, -0.6 * rg, 0);  // force along v x B = -y
+	Vector3d x = c.current.getPosition();
+	EXPECT_DOUBLE_EQ(1 * kpc, c.getCurrentStep());
+	EXPECT_DOUBLE_EQ(1 * kpc, c.getNextStep());
+	EXPECT_NEAR(0.8 * kpc, x.z, 1e-9 * kpc);
+	EXPECT_NEAR(0.6 * rg, (Vector3d(x.x, x.y, 0) - center).getR(), 1e-6 * rg);
+	EXPECT_NEAR(0.8, c.current.getDirection().z, 1e-12);
+	EXPECT_NEAR(1, c.current.getDirection().getR(), 1e-12);
+	EXPECT_EQ(Vector3d(0, 0, 0), c.previous.getPosition());
+}
+
+
+class GradientMagneticField: public MagneticField {
+	double B0, L;
+public:
+	GradientMagneticField(double B0, double L) : B0(B0), L(L) {
+	}
+	Vector3d getField(const Vector3d &position) const {
+		return Vector3d(0, 0, B0 * (1 + position.x / L));
+	}
+};
+
+TEST(testPropagationGuidingCenter, gradientDrift) {
+	// A particle gyrating perpendicular to the field drifts along b x grad |B| with
+	// v = c rg / (2 L) for the field scale length L.
+	double B0 = 1 * muG;
+	double L = 1 * kpc;
+	ref_ptr<MagneticField> field = new GradientMagneticField(B0, L);
+	PropagationGuidingCenter propa(field, 0.01, 0.01, 0, 1 * kpc);
+
+	ParticleState p;
+	p.setId(nucleusId(1, 1));
+	p.setEnergy(1e15 * eV);
+	p.setPosition(Vector3d(0, 0, 0));
+	p.setDirection(Vector3d(0, 1, 0));
+	Candidate c(p);
+	c.setNextStep(1 * kpc);
+
+	double length = 0;
+	for (size_t i = 0; i < 20; i++) {
+		propa.process(&c);
+		length += c.getCurrentStep();
+	}
+
+	// guiding centers: x - rg b x u, initially at (rg, 0, 0)
+	double rg = p.getEnergy() / (eplus * c_light * B0);
+	Vector3d x = c.current.getPosition();
+	Vector3d u = c.current.getDirection();
+	double rg1 = p.getEnergy() / (eplus * c_light * field->getField(x).getR());
+	Vector3d dX = x - Vector3d(0, 0, 1).cross(u) * rg1 - Vector3d(rg, 0, 0);
+
+	double drift = rg / (2 * (L + rg)) * length;
+	EXPECT_NEAR(drift, dX.y, 1e-2 * drift);  // to first order in rg / L
+	EXPECT_NEAR(0, dX.x, 1e-2 * drift);
+	EXPECT_NEAR(0, dX.z, 1e-2 * drift);
+}
+
+TEST(testPropagationGuidingCenter, fullOrbit) {
+	// Without adiabaticity the step is done by the full-orbit propagation.
+	ref_ptr<MagneticField> field = new GradientMagneticField(1 * nG, 1 * kpc);
+	PropagationGuidingCenter propa(field);
+	PropagationCK ck(field, 1e-4, 0.1 * kpc, 1 * Gpc);
+
+	ParticleState p;
+	p.setId(nucleusId(1, 1));
+	p.setEnergy(100 * EeV);
+	p.setDirection(Vector3d(0, 1, 0));
+	Candidate c1(p), c2(p);
+	c1.setNextStep(10 * kpc);
+	c2.setNextStep(10 * kpc);
+
+	propa.process(&c1);
+	ck.process(&c2);
+
+	EXPECT_EQ(c2.getCurrentStep(), c1.getCurrentStep());
+	EXPECT_EQ(c2.getNextStep(), c1.getNextStep());
+	EXPECT_EQ(c2.current.getPosition(), c1.current.getPosition());
+	EXPECT_EQ(c2.current.getDirection(), c1.current.getDirection());
+}
+
+TEST(testDiffusionSDE, processBatch) {
+	// Test if the batch integration agrees statistically with the single candidate one.
+	// In a uniform field with epsilon = 0 the displacement is along the field with
+	// the variance 2 D t.
+	ref_ptr<MagneticField> field = new UniformMagneticField(Vector3d(0, 0, 1 * nG));
+	DiffusionSDE diffusion(field, 1e-4, 1 * pc, 10 * pc, 0.);
+	double E = 10 * TeV;
+	double D = 6.1e24 * pow(E / eplus / 4.0e9, 1. / 3.);
+	double t = 10 * pc / c_light;
+
+	size_t N = 20000;
+	std::vector<ref_ptr<Candidate> > single, batch;
+	std::vector<Candidate *> pointers;
+	for (size_t i = 0; i < N; i++) {
+		ParticleState p;
+		p.setId(nucleusId(1, 1));
+		p.setEnergy(E);
+		p.setDirection(Vector3d(1, 0, 0));
+		Candidate *c = new Candidate(p);
+		c->setNextStep(10 * pc);
+		single.push_back(c);
+		batch.push_back(c->clone());
+		pointers.push_back(batch.back());
+	}
+	// a neutron is propagated rectilinearly
+	ParticleState p;
+	p.setId(nucleusId(1, 0));
+	p.setEnergy(E);
+	p.setDirection(Vector3d(1, 0, 0));
+	ref_ptr<Candidate> neutron = new Candidate(p);
+	neutron->setNextStep(10 * pc);
+	pointers.insert(pointers.begin() + 5, neutron);
+
+	for (size_t i = 0; i < N; i++)
+		diffusion.process(single[i]);
+	diffusion.processBatch(&pointers[0], pointers.size());
+
+	EXPECT_EQ(Vector3d(10 * pc, 0, 0), neutron->current.getPosition());
+	double var1 = 0, var2 = 0;
+	for (size_t i = 0; i < N; i++) {
+		Vector3d x1 = single[i]->current.getPosition();
+		Vector3d x2 = batch[i]->current.getPosition();
+		EXPECT_NEAR(0, x2.x, 1e-6 * pc);
+		EXPECT_NEAR(0, x2.y, 1e-6 * pc);
+		EXPECT_DOUBLE_EQ(single[i]->getCurrentStep(), batch[i]->getCurrentStep());
+		var1 += x1.z * x1.z / N;
+		var2 += x2.z * x2.z / N;
+	}
+	EXPECT_NEAR(2 * D * t, var1, 0.05 * 2 * D * t);
+	EXPECT_NEAR(2 * D * t, var2, 0.05 * 2 * D * t);
+}
+
 TEST(testPropagationBP, zeroField) {
 	PropagationBP propa(new UniformMagneticField(Vector3d(0, 0, 0)), 1 * kpc);
 